@@ -0,0 +1,221 @@
+#ifndef AUDIO_VISUALIZER_SKETCH_HPP
+#define AUDIO_VISUALIZER_SKETCH_HPP
+
+#include <SFML/Graphics.hpp>
+#include <random>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include "../lib/AudioVisualizer.hpp"
+#include "../lib/Sketch.hpp"
+
+// Shapes placed by five rules that respond to the music levels. Headless
+// renders always use the simulated analysis: real playback is tied to the
+// wall clock.
+class AudioVisualizerSketch : public Sketch {
+private:
+    static constexpr int WIDTH = 1000;
+    static constexpr int HEIGHT = 800;
+    static constexpr int SHAPE_COUNT = 500;
+
+    std::string paletteName;
+    std::vector<sf::Color> palette;
+    MusicAnalyzer analyzer;
+    RuleBasedPlacer placer;
+
+    std::mt19937 gen;
+    std::uniform_real_distribution<> sizeDist;
+    std::uniform_int_distribution<> alphaDist;
+    std::uniform_real_distribution<> rotationDist;
+    std::uniform_int_distribution<> paletteIndexDist;
+
+    float time;
+
+    std::vector<sf::RectangleShape> rects;
+    std::vector<sf::CircleShape> circles;
+    std::vector<int> shapeTypes;
+
+    // Original sizes, to prevent continuous growth
+    std::vector<sf::Vector2f> originalRectSizes;
+    std::vector<float> originalCircleRadii;
+
+    void askForMusic() {
+        std::string musicFile;
+        std::cout << "Enter music filename (or press enter for simulated music): ";
+        std::getline(std::cin, musicFile);
+
+        bool useRealMusic = false;
+        if (!musicFile.empty()) {
+            useRealMusic = analyzer.loadMusic(musicFile);
+            if (useRealMusic) {
+                analyzer.play();
+                std::cout << "Playing music file: " << musicFile << std::endl;
+            }
+        }
+
+        if (!useRealMusic) {
+            std::cout << "Using simulated music analysis." << std::endl;
+        }
+    }
+
+    void createShapes() {
+        rects.clear();
+        circles.clear();
+        shapeTypes.clear();
+        originalRectSizes.clear();
+        originalCircleRadii.clear();
+
+        for (int i = 0; i < SHAPE_COUNT; ++i) {
+            int shapeType = i % 3;
+
+            if (shapeType == 0 || shapeType == 2) {
+                sf::Vector2f originalSize(sizeDist(gen), sizeDist(gen));
+                rects.emplace_back(originalSize);
+                originalRectSizes.push_back(originalSize);
+                shapeTypes.push_back(0); // 0 for rectangle
+            } else {
+                float originalRadius = sizeDist(gen) / 2;
+                circles.emplace_back(originalRadius);
+                originalCircleRadii.push_back(originalRadius);
+                shapeTypes.push_back(1); // 1 for circle
+            }
+        }
+    }
+
+public:
+    static constexpr const char* NAME = "audiovisualizer";
+    static constexpr const char* DESCRIPTION = "Music responsive shapes";
+
+    explicit AudioVisualizerSketch(SketchResources& resources)
+        : paletteName(resources.getPaletteName()), palette(getPalette(paletteName)), placer(WIDTH, HEIGHT),
+          gen(resources.nextSeed()), sizeDist(5.0, 100.0), alphaDist(50, 200), rotationDist(0.0, 360.0),
+          paletteIndexDist(0, static_cast<int>(palette.size()) - 1), time(0.0f) {
+        if (!resources.isHeadless() && resources.canPrompt()) {
+            askForMusic();
+        }
+        createShapes();
+    }
+
+    sf::Vector2u getSize() const override {
+        return sf::Vector2u(WIDTH, HEIGHT);
+    }
+
+    void reset() override {
+        time = 0.0f;
+        createShapes();
+    }
+
+    void update(float deltaTime, const SketchInput&) override {
+        time += deltaTime;
+        analyzer.update(deltaTime);
+    }
+
+    // Places, colors and draws every shape for the current time and music levels
+    void draw(sf::RenderTarget& target) override {
+        target.clear(sf::Color(10, 10, 30));
+
+        float volume = analyzer.getVolume();
+        float bass = analyzer.getBass();
+        float mid = analyzer.getMid();
+        float treble = analyzer.getTreble();
+
+        size_t rectIndex = 0;
+        size_t circleIndex = 0;
+
+        for (size_t i = 0; i < shapeTypes.size(); ++i) {
+            float beat = std::fmod(time * (2.0f + bass * 3.0f), 1.0f);
+            float pulse = 1.0f + 0.2f * std::sin(time * 10.0f) * volume;
+
+            sf::Vector2f position;
+            int ruleType = i % 5;
+
+            switch (ruleType) {
+                case 0: // Circular placement
+                    {
+                        float angle = time * 0.5f + i * 0.1f;
+                        float radius = 100 + i % 200 * (1.0f + volume);
+                        position = placer.circularPlacement(angle, radius, beat);
+                    }
+                    break;
+                case 1: // Grid placement
+                    {
+                        int xIndex = i % 20;
+                        int yIndex = (i / 20) % 20;
+                        position = placer.gridPlacement(xIndex, yIndex, 20, 20, pulse);
+                    }
+                    break;
+                case 2: // Wave placement
+                    {
+                        float t = float(i) / shapeTypes.size();
+                        float frequency = 2.0f + treble * 5.0f;
+                        float amplitude = 100 + mid * 200;
+                        float phase = time * 2.0f;
+                        position = placer.wavePlacement(t, frequency, amplitude, phase);
+                    }
+                    break;
+                case 3: // Spiral placement
+                    {
+                        float angle = time * 0.5f + i * 0.05f;
+                        float radius = 50 + i % 100 * (1.0f + bass);
+                        float growth = 0.1f + 0.2f * mid;
+                        position = placer.spiralPlacement(angle, radius, growth, time);
+                    }
+                    break;
+                default: // Random placement
+                    position = placer.randomPlacement(gen, volume);
+                    break;
+            }
+
+            sf::Color selectedColor = palette[paletteIndexDist(gen)];
+            selectedColor.a = alphaDist(gen) * (0.7f + 0.3f * volume);
+
+            float sizeFactor = 0.8f + 0.4f * bass;
+            float rotation = rotationDist(gen) + time * 20.0f * treble;
+
+            if (shapeTypes[i] == 0) { // Rectangle
+                if (rectIndex < rects.size()) {
+                    sf::Vector2f newSize = originalRectSizes[rectIndex] * sizeFactor;
+                    rects[rectIndex].setSize(newSize);
+                    rects[rectIndex].setPosition(position);
+                    rects[rectIndex].setFillColor(selectedColor);
+                    rects[rectIndex].setRotation(rotation);
+                    rects[rectIndex].setOrigin(newSize.x / 2, newSize.y / 2);
+                    target.draw(rects[rectIndex]);
+                    rectIndex++;
+                }
+            } else { // Circle
+                if (circleIndex < circles.size()) {
+                    float newRadius = originalCircleRadii[circleIndex] * sizeFactor;
+                    circles[circleIndex].setRadius(newRadius);
+                    circles[circleIndex].setPosition(position);
+                    circles[circleIndex].setFillColor(selectedColor);
+                    circles[circleIndex].setRotation(rotation);
+                    circles[circleIndex].setOrigin(newRadius, newRadius);
+                    target.draw(circles[circleIndex]);
+                    circleIndex++;
+                }
+            }
+        }
+    }
+
+    std::string getStatus() const override {
+        std::stringstream musicData;
+        musicData << std::fixed << std::setprecision(2);
+        musicData << "Volume: " << analyzer.getVolume() << " | Bass: " << analyzer.getBass() << " | Mid: "
+                  << analyzer.getMid() << " | Treble: " << analyzer.getTreble() << " | Palette: " << paletteName;
+        return musicData.str();
+    }
+
+    float getRecordingFPS() const override {
+        return 15.0f;
+    }
+
+    unsigned int getFrameRateLimit() const override {
+        return 10;
+    }
+};
+
+#endif // AUDIO_VISUALIZER_SKETCH_HPP
@@ -0,0 +1,157 @@
+#include <SFML/Graphics.hpp>
+#include <SFML/OpenGL.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include "../lib/GIFRecorder.hpp"
+#include "../lib/LatencyStats.hpp"
+
+// Times each stage of a frame capture on the render thread, at several
+// resolutions, then runs the whole recorder at several capture rates:
+//
+//   allocate  - creating a texture the size of the frame
+//   update    - copying the window's back buffer into that texture
+//   readback  - copyToImage(), the GPU to CPU transfer
+//   copy      - memcpy of the image into a pooled frame buffer
+//   direct    - glReadPixels straight into a pooled frame buffer, the
+//               recorder's path (less its row flip) in place of update,
+//               readback and copy
+//   append    - push_back of the image into a growing std::vector<sf::Image>,
+//               the way an in-memory recorder keeps its frames (restarted
+//               every 32 frames to bound memory, so reallocations recur)
+//
+// The recorder rows render at 60 FPS and record Y4M to a null device, so
+// encoding competes for the CPU but nothing touches the disk.
+//
+//   ./capture_bench [frames]
+
+static const char* nullDevice() {
+#ifdef _WIN32
+    return "NUL";
+#else
+    return "/dev/null";
+#endif
+}
+
+static void printRow(const std::string& resolution, const std::string& stage, const LatencyStats& stats) {
+    std::cout << std::left << std::setw(12) << resolution << std::setw(14) << stage << std::right
+              << std::setw(10) << stats.mean()
+              << std::setw(10) << stats.percentile(50)
+              << std::setw(10) << stats.percentile(95)
+              << std::setw(10) << stats.percentile(99)
+              << std::setw(10) << stats.max();
+}
+
+// Something that changes every frame, so no capture is merged as identical
+static void drawScene(sf::RenderTarget& target, int frame) {
+    sf::Vector2u size = target.getSize();
+    target.clear(sf::Color(20, 20, 30));
+    sf::RectangleShape box(sf::Vector2f(size.x / 4.0f, size.y / 4.0f));
+    box.setFillColor(sf::Color(255, 120, 40));
+    box.setPosition(static_cast<float>(frame * 7 % (size.x - size.x / 4)), size.y / 3.0f);
+    target.draw(box);
+}
+
+int main(int argc, char* argv[]) {
+    const int frames = argc > 1 ? std::max(1, std::atoi(argv[1])) : 240;
+    const sf::Vector2u resolutions[] = {{640, 360}, {1280, 720}, {1920, 1080}, {2560, 1440}};
+    const float captureRates[] = {15.0f, 30.0f, 60.0f};
+    const float renderRate = 60.0f;
+
+    std::cout << frames << " frames per run, times in ms\n\n";
+    std::cout << std::left << std::setw(12) << "resolution" << std::setw(14) << "stage" << std::right
+              << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p95"
+              << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+    std::cout << std::fixed << std::setprecision(3);
+
+    for (const sf::Vector2u& size : resolutions) {
+        // Window sizes beyond the desktop may be clamped; report what we got
+        sf::RenderWindow window(sf::VideoMode(size.x, size.y), "capture_bench", sf::Style::None);
+        window.setVisible(false);
+        sf::Vector2u actual = window.getSize();
+        std::string resolution = std::to_string(actual.x) + "x" + std::to_string(actual.y);
+
+        LatencyStats allocate, update, readback, copy, direct, append;
+        sf::Texture texture;
+        texture.create(actual.x, actual.y);
+        std::vector<sf::Uint8> pooled(static_cast<size_t>(actual.x) * actual.y * 4);
+        std::vector<sf::Image> kept;
+
+        for (int f = 0; f < frames; ++f) {
+            drawScene(window, f);
+            window.display();
+
+            auto start = LatencyStats::Clock::now();
+            sf::Texture fresh;
+            fresh.create(actual.x, actual.y);
+            allocate.addSince(start);
+
+            start = LatencyStats::Clock::now();
+            texture.update(window);
+            update.addSince(start);
+
+            start = LatencyStats::Clock::now();
+            sf::Image image = texture.copyToImage();
+            readback.addSince(start);
+
+            start = LatencyStats::Clock::now();
+            std::memcpy(pooled.data(), image.getPixelsPtr(), std::min(pooled.size(),
+                        static_cast<size_t>(image.getSize().x) * image.getSize().y * 4));
+            copy.addSince(start);
+
+            start = LatencyStats::Clock::now();
+            window.setActive(true);
+            glReadPixels(0, 0, static_cast<GLsizei>(actual.x), static_cast<GLsizei>(actual.y), GL_RGBA,
+                         GL_UNSIGNED_BYTE, pooled.data());
+            direct.addSince(start);
+
+            if (kept.size() == 32) {
+                std::vector<sf::Image>().swap(kept);
+            }
+            start = LatencyStats::Clock::now();
+            kept.push_back(image);
+            append.addSince(start);
+        }
+        std::vector<sf::Image>().swap(kept);
+
+        printRow(resolution, "allocate", allocate);
+        std::cout << "\n";
+        printRow(resolution, "update", update);
+        std::cout << "\n";
+        printRow(resolution, "readback", readback);
+        std::cout << "\n";
+        printRow(resolution, "copy", copy);
+        std::cout << "\n";
+        printRow(resolution, "direct", direct);
+        std::cout << "\n";
+        printRow(resolution, "append", append);
+        std::cout << "\n";
+
+        for (float rate : captureRates) {
+            GIFRecorder recorder(actual.x, actual.y, frames, rate);
+            recorder.setFormat(RecordingFormat::Y4M);
+            recorder.setOutputPath(nullDevice());
+
+            // The recorder's own messages would break up the table
+            std::streambuf* console = std::cout.rdbuf(nullptr);
+            recorder.startRecording();
+            for (int f = 0; f < frames && recorder.isRecordingNow(); ++f) {
+                drawScene(window, f);
+                window.display();
+                recorder.update(1.0f / renderRate, window);
+            }
+            if (recorder.isRecordingNow()) {
+                recorder.stopRecording();
+            }
+            std::cout.rdbuf(console);
+
+            printRow(resolution, "recorder@" + std::to_string(static_cast<int>(rate)), recorder.getCaptureLatency());
+            std::cout << "  " << recorder.getDroppedFrames() << " dropped\n";
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,509 @@
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include "../fabric/Fabric.hpp"
+#include "../lib/LatencyStats.hpp"
+
+// Node-steps per second of a fabric step on an N x N grid pinned along the
+// top row, in three node layouts:
+//
+//   AoS        the previous layout: std::vector<Node> with a branch and a
+//              square root per node
+//   SoA scalar NodeArrays with the scalar kernels
+//   SoA SIMD   NodeArrays with the vector kernels (AVX2 or SSE2)
+//
+// A step is the per-node passes (mouse force, Verlet integration) followed
+// by PHYSICS_ITERATIONS constraint passes, as in
+// MultiLayerFabricSimulation::update. The per-node passes are what the
+// layouts change, so they are also timed on their own. The mouse sits over the middle of the grid. Also reports the
+// largest relative position difference from AoS after ten steps.
+//
+// The second table times ConstraintSolver alone on 1, 2, 4 and 8 threads,
+// in millions of constraint relaxations per second, and checks that every
+// thread count gives bit-identical positions.
+//
+// The third table compares the mouse force over every node with the same
+// force through CoarseNodeIndex, in microseconds per layer step, with the
+// brush over the middle of a hanging cloth; and what keeping the index
+// adds to the integration pass.
+//
+// The fourth table lets a one-layer cloth hang for two seconds with plain
+// Gauss-Seidel passes, with multigrid levels (MultigridSolver) before
+// fewer passes, and with XPBD substeps of one pass each, and reports the
+// cost of a step and how stretched the cloth is left: the root mean square
+// and the largest (length - rest) / rest.
+//
+// With --replay, steps a fabric through an input recording (fabric_app
+// --record PATH) as fast as it goes instead, and reports the time per
+// frame and a hash of the final node positions. Two builds that print the
+// same hash did exactly the same work, so their times compare directly.
+//
+//   ./fabric_bench [sizes...]    (default 50 256 1024)
+//   ./fabric_bench --replay PATH [threads]
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+    // The layout FabricLayer used before NodeArrays
+    struct Node {
+        sf::Vector2f position;
+        sf::Vector2f previousPosition;
+        bool isPinned = false;
+        int layerIndex = 0;
+    };
+
+    struct Grid {
+        int size;
+        std::vector<Constraint> constraints;
+        std::vector<Node> aos;
+        NodeArrays soa;
+
+        explicit Grid(int n) : size(n), aos(static_cast<size_t>(n) * n) {
+            for (int y = 0; y < n; ++y) {
+                for (int x = 0; x < n; ++x) {
+                    sf::Vector2f position(x * CELL_SIZE, y * CELL_SIZE);
+                    Node& node = aos[y * n + x];
+                    node.position = node.previousPosition = position;
+                    node.isPinned = y == 0;
+                    soa.setPinned(soa.add(position), y == 0);
+                }
+            }
+            for (int y = 0; y < n; ++y) {
+                for (int x = 0; x < n; ++x) {
+                    int index = y * n + x;
+                    if (x < n - 1) {
+                        constraints.push_back({index, index + 1, CELL_SIZE, false});
+                    }
+                    if (y < n - 1) {
+                        constraints.push_back({index, index + n, CELL_SIZE, false});
+                    }
+                }
+            }
+        }
+
+        sf::Vector2f mouse() const {
+            return sf::Vector2f(size * CELL_SIZE * 0.5f, size * CELL_SIZE * 0.5f);
+        }
+    };
+
+    void nodePassesAoS(std::vector<Node>& nodes, float deltaTime, sf::Vector2f mousePosition) {
+        for (auto& node : nodes) {
+            if (!node.isPinned) {
+                sf::Vector2f diff = mousePosition - node.position;
+                float distance = std::sqrt(diff.x * diff.x + diff.y * diff.y);
+                if (distance < MOUSE_FORCE_RADIUS) {
+                    sf::Vector2f force = -diff / (distance + 1.0f) * MOUSE_FORCE_STRENGTH;
+                    node.position += force * deltaTime;
+                }
+            }
+        }
+
+        for (auto& node : nodes) {
+            if (!node.isPinned) {
+                sf::Vector2f velocity = node.position - node.previousPosition;
+                node.previousPosition = node.position;
+                node.position += velocity * DAMPING_FACTOR;
+                node.position += sf::Vector2f(0.0f, GRAVITY * deltaTime);
+            }
+        }
+    }
+
+    void constraintsAoS(std::vector<Node>& nodes, const std::vector<Constraint>& constraints) {
+        for (int i = 0; i < PHYSICS_ITERATIONS; ++i) {
+            for (const auto& constraint : constraints) {
+                Node& nodeA = nodes[constraint.nodeAIndex];
+                Node& nodeB = nodes[constraint.nodeBIndex];
+
+                sf::Vector2f delta = nodeB.position - nodeA.position;
+                float currentLength = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+                float difference = (currentLength - constraint.length) / currentLength;
+                sf::Vector2f correction = delta * difference * 0.5f;
+
+                if (!nodeA.isPinned) {
+                    nodeA.position += correction;
+                }
+                if (!nodeB.isPinned) {
+                    nodeB.position -= correction;
+                }
+            }
+        }
+    }
+
+    void constraintsSoA(NodeArrays& nodes, const std::vector<Constraint>& constraints) {
+        float* x = nodes.x.data();
+        float* y = nodes.y.data();
+        const uint32_t* free = nodes.freeMask.data();
+        for (int i = 0; i < PHYSICS_ITERATIONS; ++i) {
+            for (const auto& constraint : constraints) {
+                int a = constraint.nodeAIndex;
+                int b = constraint.nodeBIndex;
+                float dx = x[b] - x[a];
+                float dy = y[b] - y[a];
+                float currentLength = std::sqrt(dx * dx + dy * dy);
+                float difference = (currentLength - constraint.length) / currentLength;
+                float correctionX = dx * difference * 0.5f;
+                float correctionY = dy * difference * 0.5f;
+                if (free[a]) {
+                    x[a] += correctionX;
+                    y[a] += correctionY;
+                }
+                if (free[b]) {
+                    x[b] -= correctionX;
+                    y[b] -= correctionY;
+                }
+            }
+        }
+    }
+
+    enum class Layout { AoS, SoAScalar, SoASimd };
+
+    struct Rates {
+        double nodePasses;
+        double step;
+    };
+
+    // Runs 'steps' full steps; returns node-steps per second for the
+    // per-node passes alone and for the whole step
+    Rates run(Grid& grid, Layout layout, int steps, float deltaTime) {
+        const size_t count = grid.aos.size();
+        const sf::Vector2f mouse = grid.mouse();
+        const verlet::MouseForce force = {mouse.x, mouse.y, MOUSE_FORCE_RADIUS, MOUSE_FORCE_STRENGTH * deltaTime};
+
+        double passSeconds = 0.0;
+        auto start = Clock::now();
+        for (int i = 0; i < steps; ++i) {
+            auto passStart = Clock::now();
+            if (layout == Layout::AoS) {
+                nodePassesAoS(grid.aos, deltaTime, mouse);
+            } else if (layout == Layout::SoAScalar) {
+                verlet::applyMouseForceScalar(grid.soa, 0, count, force);
+                verlet::integrateScalar(grid.soa, 0, count, DAMPING_FACTOR, GRAVITY * deltaTime);
+            } else {
+                verlet::applyMouseForce(grid.soa, 0, count, force);
+                verlet::integrate(grid.soa, 0, count, DAMPING_FACTOR, GRAVITY * deltaTime);
+            }
+            passSeconds += std::chrono::duration<double>(Clock::now() - passStart).count();
+
+            if (layout == Layout::AoS) {
+                constraintsAoS(grid.aos, grid.constraints);
+            } else {
+                constraintsSoA(grid.soa, grid.constraints);
+            }
+        }
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        double nodeSteps = static_cast<double>(count) * steps;
+        return {nodeSteps / passSeconds, nodeSteps / seconds};
+    }
+
+    float maxRelativeDifference(const Grid& a, const Grid& b) {
+        float result = 0.0f;
+        for (size_t i = 0; i < a.aos.size(); ++i) {
+            sf::Vector2f p = a.aos[i].position;
+            float scale = std::max({1.0f, std::abs(p.x), std::abs(p.y)});
+            result = std::max({result, std::abs(p.x - b.soa.x[i]) / scale, std::abs(p.y - b.soa.y[i]) / scale});
+        }
+        return result;
+    }
+
+    // The grid's constraints in the four FabricLayer colors
+    ConstraintSolver gridSolver(const Grid& grid) {
+        ConstraintSolver solver;
+        for (const auto& constraint : grid.constraints) {
+            int x = constraint.nodeAIndex % grid.size;
+            int y = constraint.nodeAIndex / grid.size;
+            bool horizontal = constraint.nodeBIndex == constraint.nodeAIndex + 1;
+            solver.add(constraint, horizontal ? (x % 2 ? HORIZONTAL_ODD : HORIZONTAL_EVEN)
+                                              : (y % 2 ? VERTICAL_ODD : VERTICAL_EVEN));
+        }
+        return solver;
+    }
+
+    void solverTable(const std::vector<int>& sizes) {
+        const int threadCounts[] = {1, 2, 4, 8};
+        std::cout << "\nConstraint solver, millions of relaxations per second (hardware threads: "
+                  << std::thread::hardware_concurrency() << ")\n\n";
+        std::cout << std::left << std::setw(12) << "grid" << std::right;
+        for (int threads : threadCounts) {
+            std::cout << std::setw(9) << threads << "T";
+        }
+        std::cout << std::setw(12) << "identical" << "\n";
+
+        for (int n : sizes) {
+            Grid grid(n);
+            // Start from a sagging, stretched cloth so every constraint works
+            for (size_t i = 0; i < grid.soa.size(); ++i) {
+                if (!grid.soa.isPinned(static_cast<int>(i))) {
+                    grid.soa.y[i] *= 1.2f;
+                }
+            }
+            ConstraintSolver solver = gridSolver(grid);
+            const int iterations = std::max(PHYSICS_ITERATIONS, static_cast<int>(40000000 / solver.size()));
+
+            std::string name = std::to_string(n) + "x" + std::to_string(n);
+            std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1);
+
+            NodeArrays reference;
+            bool identical = true;
+            for (int threads : threadCounts) {
+                ThreadPool pool(threads);
+                NodeArrays nodes = grid.soa;
+                auto start = Clock::now();
+                solver.solve(nodes, iterations, &pool);
+                double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                std::cout << std::setw(10) << solver.size() * static_cast<double>(iterations) / seconds / 1e6;
+
+                if (threads == 1) {
+                    reference = nodes;
+                } else {
+                    identical = identical && nodes.x == reference.x && nodes.y == reference.y;
+                }
+            }
+            std::cout << std::setw(12) << (identical ? "yes" : "NO") << "\n";
+        }
+    }
+
+    void mouseTable(const std::vector<int>& sizes) {
+        const float deltaTime = 1.0f / 60.0f;
+        std::cout << "\nMouse force, microseconds per layer step (brush radius " << MOUSE_FORCE_RADIUS
+                  << " px, cells " << CELL_SIZE << " px)\n\n";
+        std::cout << std::left << std::setw(12) << "grid" << std::right << std::setw(12) << "all nodes"
+                  << std::setw(10) << "query" << std::setw(14) << "nodes visited" << std::setw(12) << "integrate"
+                  << std::setw(12) << "+ index" << "\n";
+
+        for (int n : sizes) {
+            Grid grid(n);
+            // Let it hang for a while so the nodes are off the lattice
+            ConstraintSolver solver = gridSolver(grid);
+            for (int i = 0; i < 30; ++i) {
+                verlet::integrate(grid.soa, 0, grid.soa.size(), DAMPING_FACTOR, GRAVITY * deltaTime);
+                solver.solve(grid.soa, PHYSICS_ITERATIONS, nullptr);
+            }
+            const sf::Vector2f mouse = grid.mouse();
+            const verlet::MouseForce force = {mouse.x, mouse.y, MOUSE_FORCE_RADIUS, MOUSE_FORCE_STRENGTH * deltaTime};
+            const int repeats = std::max(5, static_cast<int>(20000000 / grid.soa.size()));
+
+            NodeArrays nodes = grid.soa;
+            auto start = Clock::now();
+            for (int i = 0; i < repeats; ++i) {
+                verlet::applyMouseForce(nodes, 0, nodes.size(), force);
+            }
+            double scan = std::chrono::duration<double>(Clock::now() - start).count() / repeats;
+
+            CoarseNodeIndex index;
+            index.build(n, n);
+            index.refresh(grid.soa);
+            size_t visited = 0;
+            index.query(mouse.x, mouse.y, MOUSE_FORCE_RADIUS, CELL_SIZE,
+                        [&](size_t begin, size_t end) { visited += end - begin; });
+            nodes = grid.soa;
+            start = Clock::now();
+            for (int i = 0; i < repeats; ++i) {
+                index.query(mouse.x, mouse.y, MOUSE_FORCE_RADIUS, CELL_SIZE, [&](size_t begin, size_t end) {
+                    verlet::applyMouseForce(nodes, begin, end, force);
+                });
+            }
+            double query = std::chrono::duration<double>(Clock::now() - start).count() / repeats;
+
+            // No damping or gravity, so the cloth stays put between repeats
+            nodes = grid.soa;
+            start = Clock::now();
+            for (int i = 0; i < repeats; ++i) {
+                verlet::integrate(nodes, 0, nodes.size(), 0.0f, 0.0f);
+            }
+            double integrate = std::chrono::duration<double>(Clock::now() - start).count() / repeats;
+            start = Clock::now();
+            for (int i = 0; i < repeats; ++i) {
+                index.integrate(nodes, 0.0f, 0.0f);
+            }
+            double indexed = std::chrono::duration<double>(Clock::now() - start).count() / repeats;
+
+            std::string name = std::to_string(n) + "x" + std::to_string(n);
+            std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(12) << scan * 1e6 << std::setw(10) << query * 1e6 << std::setw(14) << visited
+                      << std::setw(12) << integrate * 1e6 << std::setw(12) << indexed * 1e6 << "\n";
+        }
+    }
+
+    void stretchTable(const std::vector<int>& sizes) {
+        const float deltaTime = 1.0f / 60.0f;
+        const int steps = 120;
+        struct Setup {
+            SolverMode mode;
+            int iterations;
+            int substeps;
+            int levels;
+        };
+        // Levels past the coarsest useful one are ignored
+        const Setup setups[] = {{SOLVER_PBD, PHYSICS_ITERATIONS, 1, 0},
+                                {SOLVER_PBD, 4 * PHYSICS_ITERATIONS, 1, 0},
+                                {SOLVER_PBD, 1, 1, 16},
+                                {SOLVER_PBD, 2, 1, 16},
+                                {SOLVER_XPBD, 1, XPBD_SUBSTEPS / 2, 0},
+                                {SOLVER_XPBD, 1, XPBD_SUBSTEPS, 0},
+                                {SOLVER_XPBD, 1, 2 * XPBD_SUBSTEPS, 0}};
+        const std::vector<sf::Color> palette(1, sf::Color::White);
+
+        std::cout << "\nSolvers, one layer hanging for " << steps << " steps\n\n";
+        std::cout << std::left << std::setw(12) << "grid" << std::setw(8) << "solver" << std::right << std::setw(8)
+                  << "passes" << std::setw(10) << "substeps" << std::setw(8) << "levels" << std::setw(12) << "ms/step"
+                  << std::setw(14) << "rms stretch" << std::setw(14) << "max stretch" << "\n";
+
+        for (int n : sizes) {
+            for (const Setup& setup : setups) {
+                MultiLayerFabricSimulation fabric(palette, 1, 1, FabricGrid::fitted(n, n));
+                fabric.setSolverMode(setup.mode);
+                fabric.setIterations(setup.iterations);
+                fabric.setSubsteps(setup.substeps);
+                fabric.setMultigridLevels(setup.levels);
+                const FabricGrid& grid = fabric.getGrid();
+                // The brush well away from the cloth
+                const sf::Vector2f mouse(-10.0f * MOUSE_FORCE_RADIUS, -10.0f * MOUSE_FORCE_RADIUS);
+
+                auto start = Clock::now();
+                for (int i = 0; i < steps; ++i) {
+                    fabric.update(deltaTime, mouse);
+                }
+                double seconds = std::chrono::duration<double>(Clock::now() - start).count() / steps;
+
+                double sum = 0.0;
+                double largest = 0.0;
+                size_t count = 0;
+                auto measure = [&](int a, int b) {
+                    sf::Vector2f delta = fabric.getRenderPosition(b, 1.0f) - fabric.getRenderPosition(a, 1.0f);
+                    double stretch = std::sqrt(delta.x * delta.x + delta.y * delta.y) / grid.cellSize - 1.0;
+                    sum += stretch * stretch;
+                    largest = std::max(largest, std::abs(stretch));
+                    ++count;
+                };
+                for (int y = 0; y < grid.height; ++y) {
+                    for (int x = 0; x < grid.width; ++x) {
+                        if (x + 1 < grid.width) {
+                            measure(grid.nodeIndex(x, y), grid.nodeIndex(x + 1, y));
+                        }
+                        if (y + 1 < grid.height) {
+                            measure(grid.nodeIndex(x, y), grid.nodeIndex(x, y + 1));
+                        }
+                    }
+                }
+
+                std::string name = std::to_string(n) + "x" + std::to_string(n);
+                std::cout << std::left << std::setw(12) << name << std::setw(8)
+                          << (setup.mode == SOLVER_XPBD ? "XPBD" : "PBD") << std::right << std::setw(8)
+                          << setup.iterations << std::setw(10) << setup.substeps << std::setw(8) << setup.levels
+                          << std::fixed << std::setprecision(2) << std::setw(12) << seconds * 1e3
+                          << std::scientific << std::setprecision(2) << std::setw(14) << std::sqrt(sum / count)
+                          << std::setw(14) << largest << "\n";
+            }
+        }
+    }
+
+    int replayRecording(const std::string& path, unsigned int threads) {
+        FabricInputReplay replay;
+        if (!replay.load(path)) {
+            return 1;
+        }
+        const FabricSettings& settings = replay.getSettings();
+        const std::vector<sf::Color> palette(1, sf::Color::White);
+        MultiLayerFabricSimulation fabric(palette, settings.layers, threads,
+                                          FabricGrid::fitted(settings.gridWidth, settings.gridHeight));
+        if (!fabric.applySettings(settings)) {
+            return 1;
+        }
+
+        LatencyStats frames;
+        frames.reserve(replay.getFrameCount());
+        FabricInputFrame frame;
+        while (replay.next(frame)) {
+            auto start = LatencyStats::Clock::now();
+            fabric.advance(frame.deltaTime, sf::Vector2f(frame.mouseX, frame.mouseY));
+            frames.addSince(start);
+        }
+
+        // FNV-1a over the bits of every position
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&](float value) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            for (int i = 0; i < 4; ++i) {
+                hash = (hash ^ ((bits >> (8 * i)) & 0xff)) * 1099511628211ull;
+            }
+        };
+        for (size_t i = 0; i < fabric.getNodeCount(); ++i) {
+            sf::Vector2f position = fabric.getRenderPosition(static_cast<int>(i), 1.0f);
+            mix(position.x);
+            mix(position.y);
+        }
+
+        std::cout << "Replayed " << frames.count() << " frames of " << settings.layers << " x " << settings.gridWidth
+                  << "x" << settings.gridHeight << " nodes on " << fabric.getThreadCount() << " threads\n\n";
+        std::cout << std::fixed << std::setprecision(3) << "ms/frame    mean " << frames.mean() << "  p50 "
+                  << frames.percentile(50) << "  p95 " << frames.percentile(95) << "  max " << frames.max() << "\n";
+        std::cout << "positions   " << std::hex << std::setw(16) << std::setfill('0') << hash << std::dec
+                  << std::setfill(' ') << "\n";
+        return 0;
+    }
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 3 && std::string(argv[1]) == "--replay") {
+        unsigned int threads = argc >= 4 ? static_cast<unsigned int>(std::max(0, std::atoi(argv[3]))) : 0;
+        return replayRecording(argv[2], threads);
+    }
+
+    std::vector<int> sizes;
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(std::max(2, std::atoi(argv[i])));
+    }
+    if (sizes.empty()) {
+        sizes = {50, 256, 1024};
+    }
+
+    const float deltaTime = 1.0f / 60.0f;
+    std::cout << "Fabric node-steps per second (millions), SIMD kernel: " << verlet::kernelName() << "\n\n";
+    std::cout << std::left << std::setw(12) << "grid" << std::setw(14) << "" << std::right << std::setw(10) << "AoS"
+              << std::setw(12) << "SoA scalar" << std::setw(10) << "SoA SIMD" << std::setw(10) << "speedup" << "\n";
+
+    for (int n : sizes) {
+        const size_t count = static_cast<size_t>(n) * n;
+        const int steps = std::max(3, static_cast<int>(20000000 / count));
+
+        Grid aos(n), scalar(n), simd(n);
+        Rates aosRates = run(aos, Layout::AoS, steps, deltaTime);
+        Rates scalarRates = run(scalar, Layout::SoAScalar, steps, deltaTime);
+        Rates simdRates = run(simd, Layout::SoASimd, steps, deltaTime);
+
+        // Short runs, before rounding differences are amplified by the cloth
+        Grid checkAoS(n), checkSimd(n);
+        run(checkAoS, Layout::AoS, 10, deltaTime);
+        run(checkSimd, Layout::SoASimd, 10, deltaTime);
+        float difference = maxRelativeDifference(checkAoS, checkSimd);
+
+        std::string grid = std::to_string(n) + "x" + std::to_string(n);
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << std::left << std::setw(12) << grid << std::setw(14) << "node passes" << std::right
+                  << std::setw(10) << aosRates.nodePasses / 1e6 << std::setw(12) << scalarRates.nodePasses / 1e6
+                  << std::setw(10) << simdRates.nodePasses / 1e6 << std::setw(9)
+                  << simdRates.nodePasses / aosRates.nodePasses << "x\n";
+        std::cout << std::left << std::setw(12) << "" << std::setw(14) << "full step" << std::right
+                  << std::setw(10) << aosRates.step / 1e6 << std::setw(12) << scalarRates.step / 1e6
+                  << std::setw(10) << simdRates.step / 1e6 << std::setw(9) << simdRates.step / aosRates.step << "x\n";
+        std::cout << std::left << std::setw(12) << "" << std::setw(14) << "max rel diff" << std::right
+                  << std::scientific << std::setprecision(1) << std::setw(10) << difference << "\n";
+    }
+
+    solverTable(sizes);
+    mouseTable(sizes);
+    stretchTable(sizes);
+    return 0;
+}
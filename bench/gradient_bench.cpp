@@ -0,0 +1,82 @@
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdlib>
+#include "../lib/GradientSampler.hpp"
+#include "../lib/Palettes.hpp"
+
+// Colors a batch of random scalars four ways: hard palette indexing (what
+// the sketches used to do), the 256-entry sRGB gradient table, the scalar
+// OKLab reference, and the SIMD OKLab sampler. Reports the cost per sample
+// and the largest channel difference between the sampler and the reference.
+//
+//   ./gradient_bench [palette] [samples]
+
+using Clock = std::chrono::steady_clock;
+
+static double nanosecondsPer(Clock::time_point start, size_t count) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+}
+
+int main(int argc, char* argv[]) {
+    std::string paletteName = argc > 1 ? argv[1] : "vibrant";
+    size_t samples = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+    if (samples == 0) {
+        samples = 1;
+    }
+
+    PaletteId id = getPaletteId(paletteName);
+    const std::vector<sf::Color>& palette = getPalette(id);
+    const sf::Color* table = getGradient(id);
+    GradientSampler sampler(palette);
+
+    std::vector<float> t(samples);
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+    for (float& value : t) {
+        value = dis(gen);
+    }
+    std::vector<sf::Color> out(samples);
+    std::vector<sf::Color> reference(samples);
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < samples; ++i) {
+        int index = static_cast<int>(t[i] * (palette.size() - 1));
+        out[i] = palette[std::min(static_cast<int>(palette.size() - 1), std::max(0, index))];
+    }
+    double indexNs = nanosecondsPer(start, samples);
+
+    start = Clock::now();
+    for (size_t i = 0; i < samples; ++i) {
+        out[i] = sampleGradient(table, t[i]);
+    }
+    double tableNs = nanosecondsPer(start, samples);
+
+    start = Clock::now();
+    sampler.sampleReference(t.data(), samples, reference.data());
+    double referenceNs = nanosecondsPer(start, samples);
+
+    start = Clock::now();
+    sampler.sample(t.data(), samples, out.data());
+    double samplerNs = nanosecondsPer(start, samples);
+
+    int maxError = 0;
+    for (size_t i = 0; i < samples; ++i) {
+        maxError = std::max({maxError, std::abs(out[i].r - reference[i].r), std::abs(out[i].g - reference[i].g),
+                             std::abs(out[i].b - reference[i].b), std::abs(out[i].a - reference[i].a)});
+    }
+
+    std::cout << samples << " samples, palette '" << paletteName << "'\n\n";
+    std::cout << std::left << std::setw(22) << "method" << std::right << std::setw(12) << "ns/sample" << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::left << std::setw(22) << "palette index" << std::right << std::setw(12) << indexNs << "\n";
+    std::cout << std::left << std::setw(22) << "sRGB table" << std::right << std::setw(12) << tableNs << "\n";
+    std::cout << std::left << std::setw(22) << "OKLab reference" << std::right << std::setw(12) << referenceNs << "\n";
+    std::cout << std::left << std::setw(22) << "OKLab sampler" << std::right << std::setw(12) << samplerNs << "\n";
+    std::cout << "\nLargest channel difference from the reference: " << maxError << "/255" << std::endl;
+    return maxError <= 1 ? 0 : 1;
+}
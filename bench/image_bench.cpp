@@ -0,0 +1,87 @@
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <filesystem>
+#include "../lib/ImageWriter.hpp"
+#include "../lib/FrameSpool.hpp"
+
+// Writes every frame of a spool in each still image format and reports
+// write throughput and file size. Record the input from any sketch with
+// the Spool recording format, or headless with --format spool.
+//
+//   ./image_bench recording.spool [maxFrames] [outputDir]
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <recording.spool> [maxFrames] [outputDir]" << std::endl;
+        return 1;
+    }
+    uint64_t maxFrames = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 0;
+    std::filesystem::path outputDir = argc > 3 ? argv[3] : "image_bench_output";
+
+    FrameSpoolReader reader;
+    if (!reader.open(argv[1])) {
+        return 1;
+    }
+    uint64_t frames = reader.getFrameCount();
+    if (maxFrames > 0 && maxFrames < frames) {
+        frames = maxFrames;
+    }
+    if (frames == 0) {
+        std::cerr << "The spool has no frames." << std::endl;
+        return 1;
+    }
+    std::filesystem::create_directories(outputDir);
+
+    const unsigned int width = reader.getWidth();
+    const unsigned int height = reader.getHeight();
+    const double rawBytes = static_cast<double>(width) * height * 4;
+
+    std::cout << frames << " frames of " << width << "x" << height << "\n\n";
+    std::cout << std::left << std::setw(8) << "format" << std::right << std::setw(12) << "ms/frame"
+              << std::setw(12) << "MB/s" << std::setw(14) << "KB/frame" << std::setw(10) << "ratio" << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (ImageFormat format : {ImageFormat::PNG, ImageFormat::QOI, ImageFormat::PAM, ImageFormat::PPM}) {
+        std::unique_ptr<ImageWriter> writer = ImageWriter::create(format);
+        double milliseconds = 0.0;
+        uintmax_t fileBytes = 0;
+        int failed = 0;
+
+        for (uint64_t f = 0; f < frames; ++f) {
+            std::string path = (outputDir / ("frame_" + std::to_string(f) + writer->extension())).string();
+            auto start = Clock::now();
+            if (!writer->write(path, reader.frame(f), width, height)) {
+                failed++;
+            }
+            milliseconds += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+            std::error_code error;
+            uintmax_t size = std::filesystem::file_size(path, error);
+            if (!error) {
+                fileBytes += size;
+            }
+            std::filesystem::remove(path, error);
+        }
+
+        double perFrame = milliseconds / frames;
+        double averageBytes = static_cast<double>(fileBytes) / frames;
+        std::cout << std::left << std::setw(8) << ImageWriter::formatName(format) << std::right
+                  << std::setw(12) << perFrame
+                  << std::setw(12) << rawBytes / (perFrame * 1000.0)
+                  << std::setw(14) << averageBytes / 1024.0
+                  << std::setw(10) << averageBytes / rawBytes;
+        if (failed > 0) {
+            std::cout << "  (" << failed << " failed)";
+        }
+        std::cout << "\n";
+    }
+
+    std::filesystem::remove(outputDir);
+    return 0;
+}
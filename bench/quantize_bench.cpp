@@ -0,0 +1,114 @@
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include "../lib/ColorQuantizer.hpp"
+#include "../lib/FrameSpool.hpp"
+#include "../lib/Palettes.hpp"
+
+// Quantizes every frame of a spool twice: with median cut (a palette per
+// frame, as GIFPaletteMode::PerFrame does) and with the fixed-palette
+// lookup built from a project palette. Record the input with fabric_app:
+// press F until the format is Spool, then G to record.
+//
+//   ./quantize_bench recording.spool vibrant [maxFrames]
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Sum of squared RGB errors between a frame and its quantized indices
+static double squaredError(const uint8_t* rgba, const uint8_t* indices, size_t count,
+                           const std::vector<sf::Color>& palette) {
+    double total = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        const sf::Color& c = palette[indices[i]];
+        int dr = rgba[i * 4] - c.r;
+        int dg = rgba[i * 4 + 1] - c.g;
+        int db = rgba[i * 4 + 2] - c.b;
+        total += dr * dr + dg * dg + db * db;
+    }
+    return total;
+}
+
+static double psnr(double squaredErrorSum, double samples) {
+    double mse = squaredErrorSum / samples;
+    return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <recording.spool> [palette] [maxFrames]" << std::endl;
+        return 1;
+    }
+    std::string paletteName = argc > 2 ? argv[2] : "vibrant";
+    uint64_t maxFrames = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 0;
+
+    FrameSpoolReader reader;
+    if (!reader.open(argv[1])) {
+        return 1;
+    }
+    uint64_t frames = reader.getFrameCount();
+    if (maxFrames > 0 && maxFrames < frames) {
+        frames = maxFrames;
+    }
+    if (frames == 0) {
+        std::cerr << "The spool has no frames." << std::endl;
+        return 1;
+    }
+    size_t pixelCount = static_cast<size_t>(reader.getWidth()) * reader.getHeight();
+    std::vector<uint8_t> indices(pixelCount);
+
+    // Same seed colors fabric_app records with
+    std::vector<sf::Color> colors = getPalette(paletteName);
+    colors.push_back(sf::Color::White);
+
+    auto buildStart = Clock::now();
+    FixedPaletteQuantizer fixed;
+    fixed.setPalette(colors, sf::Color::Black);
+    double buildMs = millisecondsSince(buildStart);
+
+    MedianCutQuantizer medianCut;
+    double medianCutMs = 0.0;
+    double fixedMs = 0.0;
+    double medianCutError = 0.0;
+    double fixedError = 0.0;
+
+    for (uint64_t f = 0; f < frames; ++f) {
+        const uint8_t* rgba = reader.frame(f);
+
+        auto start = Clock::now();
+        medianCut.quantize(rgba, pixelCount);
+        medianCut.mapPixels(rgba, pixelCount, indices.data());
+        medianCutMs += millisecondsSince(start);
+        medianCutError += squaredError(rgba, indices.data(), pixelCount, medianCut.getPalette());
+
+        start = Clock::now();
+        fixed.mapPixels(rgba, pixelCount, indices.data());
+        fixedMs += millisecondsSince(start);
+        fixedError += squaredError(rgba, indices.data(), pixelCount, fixed.getPalette());
+    }
+
+    double samples = static_cast<double>(frames) * pixelCount * 3;
+    std::cout << frames << " frames of " << reader.getWidth() << "x" << reader.getHeight()
+              << ", palette '" << paletteName << "' (" << fixed.getPalette().size() << " entries, lookup built in "
+              << std::fixed << std::setprecision(2) << buildMs << " ms)\n\n";
+    std::cout << std::left << std::setw(14) << "quantizer" << std::right << std::setw(14) << "ms/frame"
+              << std::setw(14) << "Mpixel/s" << std::setw(12) << "PSNR dB" << "\n";
+
+    auto row = [&](const char* name, double totalMs, double error) {
+        double perFrame = totalMs / frames;
+        std::cout << std::left << std::setw(14) << name << std::right << std::setw(14) << perFrame
+                  << std::setw(14) << pixelCount / (perFrame * 1000.0) << std::setw(12) << psnr(error, samples) << "\n";
+    };
+    row("median cut", medianCutMs, medianCutError);
+    row("fixed", fixedMs, fixedError);
+    std::cout << "\nSpeedup: " << medianCutMs / fixedMs << "x" << std::endl;
+    return 0;
+}
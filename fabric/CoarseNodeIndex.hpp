@@ -0,0 +1,116 @@
+#ifndef COARSE_NODE_INDEX_HPP
+#define COARSE_NODE_INDEX_HPP
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include "Verlet.hpp"
+
+// Bounding boxes over runs of a lattice-ordered node array, so a circular
+// brush only visits the nodes that can be under it. Nodes start on the
+// lattice and stay near their neighbours, so each row, split into blocks
+// of up to BLOCK_NODES consecutive nodes, stays compact. A query tests the
+// rows, then the blocks of the rows it hits, and hands back contiguous
+// node ranges for the SIMD kernels.
+//
+// A separate pass to refresh the boxes would read every node, which costs
+// more than the brush saves. Instead integrate() runs the Verlet step
+// block by block and keeps the boxes the kernel returns. The constraint
+// solve then moves nodes a little further, so queries pass a margin.
+//
+// Lattices stacked one above the other (as the fabric layers are) index as
+// one taller lattice; the row ranges pick out one of them, or share the
+// rows between threads.
+class CoarseNodeIndex {
+public:
+    static constexpr int BLOCK_NODES = 64;
+
+    // For a width x height lattice in row-major order
+    void build(int width, int height) {
+        m_width = width;
+        m_height = height;
+        m_blocksPerRow = (width + BLOCK_NODES - 1) / BLOCK_NODES;
+        m_blocks.assign(static_cast<size_t>(m_blocksPerRow) * height, verlet::Bounds());
+        m_rows.assign(height, verlet::Bounds());
+    }
+
+    // Boxes from the current positions, e.g. after a reset
+    void refresh(const NodeArrays& nodes) {
+        for (int row = 0; row < m_height; ++row) {
+            verlet::Bounds rowBounds;
+            for (int block = 0; block < m_blocksPerRow; ++block) {
+                verlet::Bounds bounds;
+                for (size_t i = blockBegin(row, block); i < blockEnd(row, block); ++i) {
+                    bounds.add(nodes.x[i], nodes.y[i]);
+                }
+                m_blocks[static_cast<size_t>(row) * m_blocksPerRow + block] = bounds;
+                rowBounds.add(bounds);
+            }
+            m_rows[row] = rowBounds;
+        }
+    }
+
+    int getHeight() const {
+        return m_height;
+    }
+
+    // verlet::integrate over every node, keeping the new boxes
+    void integrate(NodeArrays& nodes, float damping, float gravityStep) {
+        integrate(nodes, damping, gravityStep, 0, m_height);
+    }
+
+    // The same over rows [firstRow, endRow)
+    void integrate(NodeArrays& nodes, float damping, float gravityStep, int firstRow, int endRow) {
+        for (int row = firstRow; row < endRow; ++row) {
+            verlet::Bounds rowBounds;
+            for (int block = 0; block < m_blocksPerRow; ++block) {
+                verlet::Bounds bounds =
+                    verlet::integrate(nodes, blockBegin(row, block), blockEnd(row, block), damping, gravityStep);
+                m_blocks[static_cast<size_t>(row) * m_blocksPerRow + block] = bounds;
+                rowBounds.add(bounds);
+            }
+            m_rows[row] = rowBounds;
+        }
+    }
+
+    // Calls visit(begin, end) for each node range that may lie within
+    // radius of (x, y), allowing the nodes to have moved by margin since
+    // the boxes were taken
+    template <typename Visit>
+    void query(float x, float y, float radius, float margin, Visit visit) const {
+        query(x, y, radius, margin, 0, m_height, visit);
+    }
+
+    // The same within rows [firstRow, endRow)
+    template <typename Visit>
+    void query(float x, float y, float radius, float margin, int firstRow, int endRow, Visit visit) const {
+        const float reach = radius + margin;
+        for (int row = firstRow; row < endRow; ++row) {
+            if (!m_rows[row].near(x, y, reach)) {
+                continue;
+            }
+            for (int block = 0; block < m_blocksPerRow; ++block) {
+                if (m_blocks[static_cast<size_t>(row) * m_blocksPerRow + block].near(x, y, reach)) {
+                    visit(blockBegin(row, block), blockEnd(row, block));
+                }
+            }
+        }
+    }
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    int m_blocksPerRow = 0;
+    std::vector<verlet::Bounds> m_blocks;
+    std::vector<verlet::Bounds> m_rows;
+
+    size_t blockBegin(int row, int block) const {
+        return static_cast<size_t>(row) * m_width + static_cast<size_t>(block) * BLOCK_NODES;
+    }
+
+    size_t blockEnd(int row, int block) const {
+        return std::min(blockBegin(row, block) + BLOCK_NODES, static_cast<size_t>(row + 1) * m_width);
+    }
+};
+
+#endif // COARSE_NODE_INDEX_HPP
@@ -0,0 +1,344 @@
+#ifndef CONSTRAINT_SOLVER_HPP
+#define CONSTRAINT_SOLVER_HPP
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include "Verlet.hpp"
+#include "../lib/ThreadPool.hpp"
+
+// A constraint (or "spring")
+struct Constraint {
+    int nodeAIndex;
+    int nodeBIndex;
+    float length;
+    bool isInterLayer = false;
+    // Inverse stiffness for solveCompliant(); 0 is rigid
+    float compliance = 0.0f;
+};
+
+// Constraints grouped by color: no two constraints of one color share a
+// node, so a color can be relaxed in any order, or split across threads,
+// and give the same positions. Colors are relaxed one after another, so
+// the result does not depend on the thread count.
+//
+// With a tear ratio set, constraints stretched past that many times their
+// length in the last iteration are removed after the solve; inter-layer
+// ones never tear.
+//
+// With residual tracking on, each iteration also measures how far the
+// constraints were from their rest lengths before it moved them: the root
+// mean square of (length - rest) / rest. See getResiduals().
+//
+// solveCompliant() relaxes the same constraints as extended position-based
+// dynamics (XPBD): each has a compliance and a Lagrange multiplier that
+// accumulates over the iterations, so its stiffness depends on the
+// timestep and not on the iteration count. Pinned nodes have no inverse
+// mass, so a thread to one is corrected in full.
+//
+// Order within a color does not matter, so removal is a swap with the color's last
+// constraint.
+class ConstraintSolver {
+public:
+    // Below this many constraints a step is too short to be worth waking
+    // the pool for
+    static constexpr size_t PARALLEL_THRESHOLD = 16384;
+
+    void clear() {
+        m_colors.clear();
+        m_touched.clear();
+        m_size = 0;
+        m_torn.clear();
+    }
+
+    // 0 never tears
+    void setTearRatio(float ratio) {
+        m_tearRatio = ratio;
+    }
+
+    float getTearRatio() const {
+        return m_tearRatio;
+    }
+
+    void setTrackResidual(bool track) {
+        m_trackResidual = track;
+        if (!track) {
+            m_residuals.clear();
+        }
+    }
+
+    bool isTrackingResidual() const {
+        return m_trackResidual;
+    }
+
+    // One residual per iteration of the last solve, with tracking on
+    const std::vector<float>& getResiduals() const {
+        return m_residuals;
+    }
+
+    // Adds to a known color, e.g. one of the four grid classes; the caller
+    // guarantees it shares no node with the rest of the color
+    void add(const Constraint& constraint, int color) {
+        if (color >= static_cast<int>(m_colors.size())) {
+            m_colors.resize(color + 1);
+            m_touched.resize(color + 1);
+        }
+        m_colors[color].push_back(constraint);
+        touch(color, constraint.nodeAIndex);
+        touch(color, constraint.nodeBIndex);
+        ++m_size;
+    }
+
+    // Adds to the first color that touches neither node; returns the color
+    int add(const Constraint& constraint) {
+        int color = 0;
+        while (color < static_cast<int>(m_colors.size()) &&
+               (isTouched(color, constraint.nodeAIndex) || isTouched(color, constraint.nodeBIndex))) {
+            ++color;
+        }
+        add(constraint, color);
+        return color;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    int colorCount() const {
+        return static_cast<int>(m_colors.size());
+    }
+
+    const std::vector<Constraint>& color(int index) const {
+        return m_colors[index];
+    }
+
+    // Sets the compliance of every constraint but the inter-layer ones
+    void setCompliance(float compliance) {
+        for (auto& constraints : m_colors) {
+            for (auto& constraint : constraints) {
+                if (!constraint.isInterLayer) {
+                    constraint.compliance = compliance;
+                }
+            }
+        }
+    }
+
+    // Removes a constraint by moving the color's last one into its place
+    void remove(int color, size_t index) {
+        auto& constraints = m_colors[color];
+        untouch(color, constraints[index].nodeAIndex);
+        untouch(color, constraints[index].nodeBIndex);
+        constraints[index] = constraints.back();
+        constraints.pop_back();
+        --m_size;
+    }
+
+    // Relaxes every constraint 'iterations' times. With a pool, each color
+    // is split across the workers, which meet at a barrier before the next.
+    // Returns the number of constraints torn; see getTorn().
+    size_t solve(NodeArrays& nodes, int iterations, ThreadPool* pool) {
+        m_compliant = false;
+        return run(nodes, iterations, pool);
+    }
+
+    // The same as XPBD over a step of timestep seconds, typically a small
+    // substep with one iteration. The multipliers start from zero.
+    size_t solveCompliant(NodeArrays& nodes, int iterations, float timestep, ThreadPool* pool) {
+        m_compliant = true;
+        m_inverseStepSquared = 1.0f / (timestep * timestep);
+        m_lambdas.resize(m_colors.size());
+        for (size_t c = 0; c < m_colors.size(); ++c) {
+            m_lambdas[c].assign(m_colors[c].size(), 0.0f);
+        }
+        return run(nodes, iterations, pool);
+    }
+
+    // Constraints removed by the last solve
+    const std::vector<Constraint>& getTorn() const {
+        return m_torn;
+    }
+
+private:
+    std::vector<std::vector<Constraint>> m_colors;
+    // Per color, whether each node already has a constraint in it
+    std::vector<std::vector<bool>> m_touched;
+    size_t m_size = 0;
+    float m_tearRatio = 0.0f;
+    bool m_trackResidual = false;
+    std::vector<double> m_errors;
+    std::vector<float> m_residuals;
+    // Per worker, (color, index) of constraints past the tear ratio
+    std::vector<std::vector<std::pair<int, size_t>>> m_found;
+    std::vector<Constraint> m_torn;
+    // The compliant solve's multipliers, per color, and 1 / timestep^2
+    bool m_compliant = false;
+    std::vector<std::vector<float>> m_lambdas;
+    float m_inverseStepSquared = 0.0f;
+
+    size_t run(NodeArrays& nodes, int iterations, ThreadPool* pool) {
+        m_torn.clear();
+        const bool tearing = m_tearRatio > 0.0f;
+        const int workers = pool ? pool->size() : 1;
+        m_found.resize(std::max<size_t>(m_found.size(), workers));
+        // Per worker and iteration, the sum of squared relative errors
+        m_errors.assign(static_cast<size_t>(workers) * iterations, 0.0);
+
+        if (!pool || pool->size() == 1 || m_size < PARALLEL_THRESHOLD) {
+            for (int i = 0; i < iterations; ++i) {
+                for (int c = 0; c < colorCount(); ++c) {
+                    m_errors[i] +=
+                        relaxColor(nodes, c, 0, m_colors[c].size(), tearing && i == iterations - 1, m_found[0]);
+                }
+            }
+        } else {
+            pool->run([&](int worker, int count) {
+                for (int i = 0; i < iterations; ++i) {
+                    for (int c = 0; c < colorCount(); ++c) {
+                        auto range = ThreadPool::split(m_colors[c].size(), worker, count);
+                        m_errors[static_cast<size_t>(worker) * iterations + i] +=
+                            relaxColor(nodes, c, range.first, range.second, tearing && i == iterations - 1,
+                                       m_found[worker]);
+                        pool->sync();
+                    }
+                }
+            });
+        }
+
+        if (m_trackResidual) {
+            m_residuals.assign(iterations, 0.0f);
+            for (int i = 0; i < iterations; ++i) {
+                double sum = 0.0;
+                for (int worker = 0; worker < workers; ++worker) {
+                    sum += m_errors[static_cast<size_t>(worker) * iterations + i];
+                }
+                m_residuals[i] = m_size > 0 ? static_cast<float>(std::sqrt(sum / m_size)) : 0.0f;
+            }
+        }
+
+        if (tearing) {
+            removeFound();
+        }
+        return m_torn.size();
+    }
+
+    void touch(int color, int node) {
+        auto& touched = m_touched[color];
+        if (node >= static_cast<int>(touched.size())) {
+            touched.resize(node + 1, false);
+        }
+        touched[node] = true;
+    }
+
+    void untouch(int color, int node) {
+        m_touched[color][node] = false;
+    }
+
+    bool isTouched(int color, int node) const {
+        const auto& touched = m_touched[color];
+        return node < static_cast<int>(touched.size()) && touched[node];
+    }
+
+    // Returns the squared relative errors summed, with tracking on
+    double relaxColor(NodeArrays& nodes, int color, size_t begin, size_t end, bool checkTears,
+                      std::vector<std::pair<int, size_t>>& found) {
+        return m_compliant ? relaxColor<true>(nodes, color, begin, end, checkTears, found)
+                           : relaxColor<false>(nodes, color, begin, end, checkTears, found);
+    }
+
+    template <bool Compliant>
+    double relaxColor(NodeArrays& nodes, int color, size_t begin, size_t end, bool checkTears,
+                      std::vector<std::pair<int, size_t>>& found) {
+        if (m_trackResidual) {
+            return checkTears ? relax<true, true, Compliant>(nodes, color, begin, end, found)
+                              : relax<false, true, Compliant>(nodes, color, begin, end, found);
+        }
+        return checkTears ? relax<true, false, Compliant>(nodes, color, begin, end, found)
+                          : relax<false, false, Compliant>(nodes, color, begin, end, found);
+    }
+
+    // Plain: moves both ends of each constraint halfway back to its rest
+    // length; pinned ends stay put. Compliant: the XPBD update, weighted by
+    // the ends' inverse masses. Only the CheckTears and TrackResidual builds
+    // look at the ratio and the error, so plain solves cost nothing extra.
+    template <bool CheckTears, bool TrackResidual, bool Compliant>
+    double relax(NodeArrays& nodes, int color, size_t begin, size_t end, std::vector<std::pair<int, size_t>>& found) {
+        double error = 0.0;
+        float* x = nodes.x.data();
+        float* y = nodes.y.data();
+        const uint32_t* free = nodes.freeMask.data();
+        const Constraint* constraints = m_colors[color].data();
+        float* lambdas = Compliant ? m_lambdas[color].data() : nullptr;
+        for (size_t i = begin; i < end; ++i) {
+            const Constraint* constraint = constraints + i;
+            int a = constraint->nodeAIndex;
+            int b = constraint->nodeBIndex;
+
+            float dx = x[b] - x[a];
+            float dy = y[b] - y[a];
+            float currentLength = std::sqrt(dx * dx + dy * dy);
+
+            if (CheckTears && !constraint->isInterLayer && currentLength > constraint->length * m_tearRatio) {
+                found.emplace_back(color, i);
+            }
+            if (TrackResidual) {
+                float relative = (currentLength - constraint->length) / constraint->length;
+                error += relative * relative;
+            }
+
+            if (Compliant) {
+                float weightA = free[a] ? 1.0f : 0.0f;
+                float weightB = free[b] ? 1.0f : 0.0f;
+                float alpha = constraint->compliance * m_inverseStepSquared;
+                float denominator = weightA + weightB + alpha;
+                if (denominator <= 0.0f || currentLength <= 0.0f) {
+                    continue;
+                }
+                float& lambda = lambdas[i];
+                float deltaLambda = (constraint->length - currentLength - alpha * lambda) / denominator;
+                lambda += deltaLambda;
+                float scale = deltaLambda / currentLength;
+                x[a] -= weightA * dx * scale;
+                y[a] -= weightA * dy * scale;
+                x[b] += weightB * dx * scale;
+                y[b] += weightB * dy * scale;
+                continue;
+            }
+
+            float difference = (currentLength - constraint->length) / currentLength;
+            float correctionX = dx * difference * 0.5f;
+            float correctionY = dy * difference * 0.5f;
+
+            if (free[a]) {
+                x[a] += correctionX;
+                y[a] += correctionY;
+            }
+            if (free[b]) {
+                x[b] -= correctionX;
+                y[b] -= correctionY;
+            }
+        }
+        return error;
+    }
+
+    // Swap-and-pop, from the back of each color so that no index still to
+    // be removed is moved
+    void removeFound() {
+        std::vector<std::pair<int, size_t>> all;
+        for (auto& found : m_found) {
+            all.insert(all.end(), found.begin(), found.end());
+            found.clear();
+        }
+        std::sort(all.begin(), all.end(), [](const std::pair<int, size_t>& a, const std::pair<int, size_t>& b) {
+            return a.first != b.first ? a.first < b.first : a.second > b.second;
+        });
+
+        for (const auto& entry : all) {
+            m_torn.push_back(m_colors[entry.first][entry.second]);
+            remove(entry.first, entry.second);
+        }
+    }
+};
+
+#endif // CONSTRAINT_SOLVER_HPP
@@ -0,0 +1,1069 @@
+#ifndef FABRIC_HPP
+#define FABRIC_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cmath>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include "Verlet.hpp"
+#include "ConstraintSolver.hpp"
+#include "MultigridSolver.hpp"
+#include "CoarseNodeIndex.hpp"
+#include "FabricMesh.hpp"
+#include "FabricRecording.hpp"
+#include "FabricCache.hpp"
+#include "../lib/ThreadPool.hpp"
+#include "../lib/FixedTimestep.hpp"
+#include "../lib/TripleBuffer.hpp"
+#include "../lib/SpscQueue.hpp"
+
+// Defaults; see FabricGrid
+const int GRID_WIDTH = 50;
+const int GRID_HEIGHT = 50;
+const float CELL_SIZE = 20.0f;
+const int MAX_GRID_SIZE = 4096;
+const float DAMPING_FACTOR = 0.995f;
+const int PHYSICS_ITERATIONS = 5;
+const int MULTIGRID_LEVELS = 8; // with the multigrid on; see MultigridSolver
+const int XPBD_SUBSTEPS = 10; // with the XPBD solver, one pass each
+const float MOUSE_FORCE_RADIUS = 150.0f;
+const float MOUSE_FORCE_STRENGTH = 200.0f;
+const int SEGMENTS_PER_CONSTRAINT = 8; // with curves on
+const int NUM_LAYERS = 5; // default; see MultiLayerFabricSimulation
+const float LAYER_DEPTH_OFFSET = 5.0f;
+const int MOUSE_HISTORY_SIZE = 10;
+const float GRAVITY = 9.8f;
+const float TEAR_RATIO = 1.3f; // stretch at which a thread tears, with tearing on
+const float PHYSICS_HZ = 60.0f;
+const int MAX_SUBSTEPS = 4;
+
+// Nodes across and down, and the spacing between them
+struct FabricGrid {
+    int width = GRID_WIDTH;
+    int height = GRID_HEIGHT;
+    float cellSize = CELL_SIZE;
+
+    // A width x height grid that spans about as much as the default one
+    static FabricGrid fitted(int width, int height) {
+        FabricGrid grid;
+        grid.width = std::max(2, std::min(width, MAX_GRID_SIZE));
+        grid.height = std::max(2, std::min(height, MAX_GRID_SIZE));
+        grid.cellSize = std::min(CELL_SIZE, CELL_SIZE * GRID_WIDTH / std::max(grid.width, grid.height));
+        return grid;
+    }
+
+    int nodeCount() const {
+        return width * height;
+    }
+
+    int nodeIndex(int x, int y) const {
+        return y * width + x;
+    }
+
+    // Curve pieces between two nodes; fewer once a cell is only a few
+    // pixels across
+    int segmentsPerConstraint() const {
+        return std::max(1, std::min(SEGMENTS_PER_CONSTRAINT, static_cast<int>(cellSize / 2.5f)));
+    }
+
+    // The four corners: top-left, top-right, bottom-left, bottom-right
+    std::vector<int> corners() const {
+        return {nodeIndex(0, 0), nodeIndex(width - 1, 0), nodeIndex(0, height - 1), nodeIndex(width - 1, height - 1)};
+    }
+};
+
+// Colors of the structural constraints: horizontal ones from even and odd
+// columns, vertical ones from even and odd rows. Each class touches every
+// node at most once.
+enum GridColor {
+    HORIZONTAL_EVEN,
+    HORIZONTAL_ODD,
+    VERTICAL_EVEN,
+    VERTICAL_ODD
+};
+
+// How a step relaxes the constraints: PBD passes after one integration, or
+// XPBD substeps of an integration and one compliant pass each
+enum SolverMode {
+    SOLVER_PBD,
+    SOLVER_XPBD
+};
+
+// What drawing the fabric needs, copied out by a physics thread. The links
+// of a layer are only copied again when its torn count changes.
+struct FabricLayerSnapshot {
+    std::vector<uint8_t> links;
+    size_t tornCount = 0;
+};
+
+struct FabricSnapshot {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<FabricLayerSnapshot> layers;
+    uint64_t steps = 0;
+    float stepMilliseconds = 0.0f;
+    float residual = 0.0f;
+};
+
+// One layer of the fabric: a width x height block of the simulation's node
+// pool starting at getFirst(), with its grid threads and how they are drawn.
+// Node indices passed in and out are indices into the pool.
+class FabricLayer {
+public:
+    FabricLayer(int layerIndex, float depthOffset, const std::vector<sf::Color>& palette,
+                const FabricGrid& grid = FabricGrid())
+        : m_grid(grid), m_first(layerIndex * grid.nodeCount()), m_layerIndex(layerIndex), m_depthOffset(depthOffset),
+          m_palette(palette) {}
+
+    // Appends the layer's nodes to the pool, which must hold exactly the
+    // layers before it
+    void addNodes(NodeArrays& nodes) {
+        m_links.assign(m_grid.nodeCount(), 0);
+        m_tornCount = 0;
+        m_meshTornCount = MESH_STALE;
+
+        const float cellSize = m_grid.cellSize;
+        for (int y = 0; y < m_grid.height; ++y) {
+            for (int x = 0; x < m_grid.width; ++x) {
+                int index = nodes.add(sf::Vector2f(x * cellSize, y * cellSize + m_depthOffset));
+
+                // Pin the nodes on the top border
+                if (y == 0) {
+                    nodes.setPinned(index, true);
+                }
+            }
+        }
+    }
+
+    // The grid threads, in the four GridColor colors. Layers share no
+    // nodes, so every layer's threads can go in the same four.
+    void addConstraints(ConstraintSolver& solver, const NodeArrays& nodes) {
+        for (int y = 0; y < m_grid.height; ++y) {
+            for (int x = 0; x < m_grid.width; ++x) {
+                int index = m_grid.nodeIndex(x, y);
+
+                if (x < m_grid.width - 1) {
+                    solver.add(makeConstraint(nodes, m_first + index, m_first + index + 1, false),
+                               x % 2 ? HORIZONTAL_ODD : HORIZONTAL_EVEN);
+                    m_links[index] |= LINK_RIGHT;
+                }
+                if (y < m_grid.height - 1) {
+                    solver.add(makeConstraint(nodes, m_first + index, m_first + m_grid.nodeIndex(x, y + 1), false),
+                               y % 2 ? VERTICAL_ODD : VERTICAL_EVEN);
+                    m_links[index] |= LINK_DOWN;
+                }
+            }
+        }
+    }
+
+    int getFirst() const {
+        return m_first;
+    }
+
+    bool contains(int index) const {
+        return index >= m_first && index < m_first + m_grid.nodeCount();
+    }
+
+    // Marks the grid thread between two of the layer's nodes as torn
+    void unlink(int nodeA, int nodeB) {
+        int a = std::min(nodeA, nodeB) - m_first;
+        int b = std::max(nodeA, nodeB) - m_first;
+        m_links[a] &= b == a + 1 ? ~LINK_RIGHT : ~LINK_DOWN;
+        ++m_tornCount;
+    }
+
+    // Whether the grid thread from a node to its right (or lower)
+    // neighbour is intact
+    bool isLinked(int index, bool horizontal) const {
+        return m_links[index - m_first] & (horizontal ? LINK_RIGHT : LINK_DOWN);
+    }
+
+    // Grid threads torn since the nodes were added
+    size_t getTornCount() const {
+        return m_tornCount;
+    }
+
+    // Copies the links for drawing on another thread
+    void capture(FabricLayerSnapshot& snapshot) const {
+        if (snapshot.tornCount != m_tornCount || snapshot.links.size() != m_links.size()) {
+            snapshot.links = m_links;
+            snapshot.tornCount = m_tornCount;
+        }
+    }
+
+    // Straight lines between nodes, or curves through them; takes effect
+    // at the next draw
+    void setCurved(bool curved) {
+        m_curved = curved;
+        m_meshTornCount = MESH_STALE;
+    }
+
+    bool isCurved() const {
+        return m_curved;
+    }
+
+    size_t getVertexCount() const {
+        return m_mesh.getVertexCount();
+    }
+
+    // position(index) is where to draw a node of the pool
+    template <typename Position>
+    void draw(sf::RenderTarget& target, Position position) {
+        draw(target, m_links, m_tornCount, position);
+    }
+
+    // The same with links captured on another thread, which may be
+    // stepping the live ones. Only the mesh is touched.
+    template <typename Position>
+    void draw(sf::RenderTarget& target, const FabricLayerSnapshot& snapshot, Position position) {
+        draw(target, snapshot.links, snapshot.tornCount, position);
+    }
+
+    const FabricGrid& getGrid() const {
+        return m_grid;
+    }
+
+    // A constraint at the current distance between two nodes of the pool
+    static Constraint makeConstraint(const NodeArrays& nodes, int nodeA, int nodeB, bool isInterLayer) {
+        Constraint c;
+        c.nodeAIndex = nodeA;
+        c.nodeBIndex = nodeB;
+        sf::Vector2f delta = nodes.position(nodeB) - nodes.position(nodeA);
+        c.length = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+        c.isInterLayer = isInterLayer;
+        return c;
+    }
+
+private:
+    // m_links bits: the thread to the right and the one below are intact
+    static constexpr uint8_t LINK_RIGHT = 1;
+    static constexpr uint8_t LINK_DOWN = 2;
+    static constexpr size_t MESH_STALE = static_cast<size_t>(-1);
+
+    FabricGrid m_grid;
+    int m_first;
+    std::vector<uint8_t> m_links;
+    size_t m_tornCount = 0;
+    // Only the drawing thread touches the mesh; it is rebuilt whenever the
+    // torn count differs from the one it was built for
+    FabricMesh m_mesh;
+    size_t m_meshTornCount = MESH_STALE;
+    bool m_curved = false;
+    int m_layerIndex;
+    float m_depthOffset;
+    std::vector<sf::Color> m_palette;
+
+    template <typename Position>
+    void draw(sf::RenderTarget& target, const std::vector<uint8_t>& links, size_t tornCount, Position position) {
+        if (m_meshTornCount != tornCount) {
+            buildMesh(links, tornCount);
+        }
+        m_mesh.update([&](int index) { return position(m_first + index); });
+        m_mesh.draw(target);
+    }
+
+    // A strip per run of intact threads along each row and column, so an
+    // untorn grid is one strip per row and per column. Only rebuilt after
+    // a tear.
+    void buildMesh(const std::vector<uint8_t>& links, size_t tornCount) {
+        std::vector<FabricStrip> strips;
+        for (int y = 0; y < m_grid.height; ++y) {
+            addStrips(strips, links, m_grid.nodeIndex(0, y), 1, m_grid.width, LINK_RIGHT);
+        }
+        for (int x = 0; x < m_grid.width; ++x) {
+            addStrips(strips, links, m_grid.nodeIndex(x, 0), m_grid.width, m_grid.height, LINK_DOWN);
+        }
+        m_meshTornCount = tornCount;
+
+        // Use colors from the palette based on layer index
+        sf::Color color = m_palette[m_layerIndex % m_palette.size()];
+        color.a = 200; // Set alpha transparency
+        m_mesh.build(strips, color, m_curved ? m_grid.segmentsPerConstraint() : 1);
+    }
+
+    // Splits a row or column of count nodes where its link bit is clear
+    static void addStrips(std::vector<FabricStrip>& strips, const std::vector<uint8_t>& links, int first, int stride,
+                          int count, uint8_t link) {
+        int start = 0;
+        for (int i = 0; i < count; ++i) {
+            if (i == count - 1 || !(links[first + i * stride] & link)) {
+                if (i > start) {
+                    strips.push_back({first + start * stride, stride, i - start + 1});
+                }
+                start = i + 1;
+            }
+        }
+    }
+};
+
+// Every layer's nodes in one pool, layer after layer, stepped as one batch:
+// one brush pass per layer, one integration and one constraint solve. The
+// layers hang from springs between their matching corners, which the
+// solver relaxes along with the grid threads. With multigrid levels set,
+// coarse corrections (see MultigridSolver) run before the solve, so fewer
+// iterations hold the cloth as taut. In XPBD mode the threads' stiffness
+// comes from their compliance and the substep length instead of the pass
+// count.
+//
+// advance() can record its inputs (see FabricRecording.hpp); the same
+// frames replayed into a fabric with the same settings repeat the run.
+// Each step can also be written to a cache (see FabricCache.hpp), which
+// playback then draws instead of simulating.
+class MultiLayerFabricSimulation {
+public:
+    // threads = 0 uses every hardware thread
+    MultiLayerFabricSimulation(const std::vector<sf::Color>& palette, int layerCount = NUM_LAYERS,
+                               unsigned int threads = 0, const FabricGrid& grid = FabricGrid())
+        : m_grid(grid), m_palette(palette), m_pool(threads), m_timestep(PHYSICS_HZ, MAX_SUBSTEPS), m_curved(false),
+          m_tearRatio(0.0f), m_iterations(PHYSICS_ITERATIONS), m_multigridLevels(0),
+          m_solverMode(SOLVER_PBD), m_substeps(XPBD_SUBSTEPS), m_compliance(0.0f),
+          m_stepMilliseconds(0.0f), m_physicsRunning(false) {
+        m_solver.setTrackResidual(true);
+        setLayerCount(layerCount);
+    }
+
+    ~MultiLayerFabricSimulation() {
+        stopPhysicsThread();
+    }
+
+    // Steps the fabric on a thread of its own at the timestep's rate, from
+    // then on independent of the frame rate. advance() only queues the
+    // mouse position, and draw() draws the latest step the thread has
+    // published, so a slow solve never holds up a frame. Changes to the
+    // layers, tearing or the rate stop the thread while they are made.
+    //
+    // Steps then follow the wall clock, so frames are no longer
+    // reproducible. There is nothing to step during playback.
+    void startPhysicsThread() {
+        if (m_physicsRunning || m_cache.isOpen()) {
+            return;
+        }
+        m_snapshots.reset();
+        m_mouseInput.clear();
+        publishSnapshot(0);
+        m_snapshots.update();
+        m_physicsRunning = true;
+        m_physicsThread = std::thread([this]() { runPhysics(); });
+    }
+
+    void stopPhysicsThread() {
+        if (!m_physicsRunning) {
+            return;
+        }
+        m_physicsRunning = false;
+        m_physicsThread.join();
+        // Carry on from the last state drawn
+        savePreviousState();
+        m_timestep.reset();
+    }
+
+    bool isPhysicsThreaded() const {
+        return m_physicsRunning;
+    }
+
+    // Physics steps taken on the physics thread since it started
+    uint64_t getPhysicsSteps() const {
+        return m_snapshots.read().steps;
+    }
+
+    // Rebuilds the fabric with a new number of layers. Past NUM_LAYERS they
+    // share the default depth instead of sliding off the bottom. Playback
+    // keeps the cache's layers.
+    void setLayerCount(int layerCount) {
+        if (m_cache.isOpen()) {
+            return;
+        }
+        whilePaused([&]() { resize(layerCount); });
+    }
+
+    int getLayerCount() const {
+        return static_cast<int>(m_layers.size());
+    }
+
+    const FabricGrid& getGrid() const {
+        return m_grid;
+    }
+
+    void setCurved(bool curved) {
+        m_curved = curved;
+        for (auto& layer : m_layers) {
+            layer.setCurved(curved);
+        }
+    }
+
+    bool isCurved() const {
+        return m_curved;
+    }
+
+    // Threads stretched past ratio times their length tear; 0 turns tearing
+    // off. Torn threads stay torn until initialize().
+    void setTearRatio(float ratio) {
+        m_tearRatio = std::max(0.0f, ratio);
+        whilePaused([&]() { m_solver.setTearRatio(m_tearRatio); });
+    }
+
+    float getTearRatio() const {
+        return m_tearRatio;
+    }
+
+    size_t getTornCount() const {
+        size_t count = 0;
+        if (m_cache.isOpen()) {
+            for (const auto& layer : m_cacheLayers) {
+                count += layer.tornCount;
+            }
+            return count;
+        }
+        if (m_physicsRunning) {
+            for (const auto& layer : m_snapshots.read().layers) {
+                count += layer.tornCount;
+            }
+            return count;
+        }
+        for (const auto& layer : m_layers) {
+            count += layer.getTornCount();
+        }
+        return count;
+    }
+
+    void setSolverMode(SolverMode mode) {
+        whilePaused([&]() { m_solverMode = mode; });
+    }
+
+    SolverMode getSolverMode() const {
+        return m_solverMode;
+    }
+
+    // Substeps per step in XPBD mode
+    void setSubsteps(int substeps) {
+        whilePaused([&]() { m_substeps = std::max(1, substeps); });
+    }
+
+    int getSubsteps() const {
+        return m_substeps;
+    }
+
+    // Compliance of the grid threads in XPBD mode; 0 is inextensible, and
+    // larger values stretch more under the same load
+    void setCompliance(float compliance) {
+        whilePaused([&]() {
+            m_compliance = std::max(0.0f, compliance);
+            m_solver.setCompliance(m_compliance);
+        });
+    }
+
+    float getCompliance() const {
+        return m_compliance;
+    }
+
+    // Constraint solver passes per step in PBD mode
+    void setIterations(int iterations) {
+        whilePaused([&]() { m_iterations = std::max(1, iterations); });
+    }
+
+    int getIterations() const {
+        return m_iterations;
+    }
+
+    // Coarse levels run before the solve; 0 turns the multigrid off
+    void setMultigridLevels(int levels) {
+        whilePaused([&]() {
+            m_multigridLevels = std::max(0, levels);
+            buildMultigrid();
+        });
+    }
+
+    int getMultigridLevels() const {
+        return m_multigridLevels;
+    }
+
+    // Residual of each solver pass in the last step (one per substep in
+    // XPBD mode); see ConstraintSolver
+    const std::vector<float>& getResiduals() const {
+        return m_residuals;
+    }
+
+    // Residual of the last pass: how stretched the cloth is left
+    float getResidual() const {
+        if (m_physicsRunning) {
+            return m_snapshots.read().residual;
+        }
+        return m_residuals.empty() ? 0.0f : m_residuals.back();
+    }
+
+    size_t getVertexCount() const {
+        size_t count = 0;
+        for (const auto& layer : m_layers) {
+            count += layer.getVertexCount();
+        }
+        return count;
+    }
+
+    size_t getNodeCount() const {
+        return m_nodes.size();
+    }
+
+    size_t getConstraintCount() const {
+        return m_solver.size();
+    }
+
+    void initialize() {
+        whilePaused([&]() { rebuild(); });
+    }
+
+    // Everything the steps depend on, for recordings
+    FabricSettings getSettings() const {
+        FabricSettings settings;
+        settings.gridWidth = m_grid.width;
+        settings.gridHeight = m_grid.height;
+        settings.layers = getLayerCount();
+        settings.physicsHz = m_timestep.getRate();
+        settings.maxSubsteps = m_timestep.getMaxSubsteps();
+        settings.tearRatio = m_tearRatio;
+        settings.iterations = m_iterations;
+        settings.multigridLevels = m_multigridLevels;
+        settings.solverMode = m_solverMode;
+        settings.substeps = m_substeps;
+        settings.compliance = m_compliance;
+        return settings;
+    }
+
+    // Takes a recording's settings and starts over; the grid is fixed at
+    // construction, so it fails if the grid is not the recording's
+    bool applySettings(const FabricSettings& settings) {
+        if (settings.gridWidth != m_grid.width || settings.gridHeight != m_grid.height) {
+            std::cerr << "Fabric: the recording is of a " << settings.gridWidth << "x" << settings.gridHeight
+                      << " grid, not " << m_grid.width << "x" << m_grid.height << std::endl;
+            return false;
+        }
+        whilePaused([&]() {
+            m_timestep.setRate(settings.physicsHz);
+            m_timestep.setMaxSubsteps(settings.maxSubsteps);
+            m_tearRatio = settings.tearRatio;
+            m_solver.setTearRatio(m_tearRatio);
+            m_iterations = std::max(1, settings.iterations);
+            m_multigridLevels = std::max(0, settings.multigridLevels);
+            m_solverMode = settings.solverMode == SOLVER_XPBD ? SOLVER_XPBD : SOLVER_PBD;
+            m_substeps = std::max(1, settings.substeps);
+            m_compliance = std::max(0.0f, settings.compliance);
+            resize(settings.layers);
+        });
+        return true;
+    }
+
+    // Starts over (unless nothing has stepped yet) and records every
+    // advance() to path until stopRecording(), a rebuild or a change of
+    // settings
+    bool startRecording(const std::string& path) {
+        stopRecording();
+        bool opened = false;
+        whilePaused([&]() {
+            startOver();
+            opened = m_recorder.open(path, getSettings());
+        });
+        return opened;
+    }
+
+    void stopRecording() {
+        m_recorder.close();
+    }
+
+    bool isRecording() const {
+        return m_recorder.isOpen();
+    }
+
+    uint64_t getRecordedFrames() const {
+        return m_recorder.getFrameCount();
+    }
+
+    // Starts over (unless nothing has stepped yet) and writes every step
+    // to a cache at path, with positions in 16 bits if quantized, until
+    // stopCaching() or a rebuild
+    bool startCaching(const std::string& path, bool quantized) {
+        stopPlayback();
+        bool opened = false;
+        whilePaused([&]() {
+            m_cacheWriter.close();
+            startOver();
+            opened = m_cacheWriter.open(path, getSettings(), static_cast<uint32_t>(getLayerCount()),
+                                        static_cast<uint32_t>(m_nodes.size()), quantized);
+            if (opened) {
+                appendCacheFrame();
+            }
+        });
+        return opened;
+    }
+
+    void stopCaching() {
+        whilePaused([&]() { m_cacheWriter.close(); });
+    }
+
+    bool isCaching() const {
+        return m_cacheWriter.isOpen();
+    }
+
+    uint64_t getCachedFrames() const {
+        return m_cacheWriter.getFrameCount();
+    }
+
+    // Draws the steps of a cache instead of simulating: advance() moves
+    // through them at the cache's physics rate without stepping anything,
+    // and draw() shows them, so one run can be rendered again with other
+    // palettes, curves or recording settings. The grid must be the cache's;
+    // the layers become the cache's.
+    bool startPlayback(const std::string& path) {
+        stopPlayback();
+        stopCaching();
+        stopPhysicsThread();
+        if (!m_cache.open(path)) {
+            return false;
+        }
+        const FabricSettings& settings = m_cache.getSettings();
+        if (settings.gridWidth != m_grid.width || settings.gridHeight != m_grid.height ||
+            m_cache.getNodeCount() != static_cast<uint32_t>(settings.layers * m_grid.nodeCount()) ||
+            m_cache.getFrameCount() == 0) {
+            std::cerr << "Fabric: " << path << " is not a cache of a " << m_grid.width << "x" << m_grid.height
+                      << " grid, or is empty" << std::endl;
+            m_cache.close();
+            return false;
+        }
+        m_timestep.setRate(settings.physicsHz);
+        m_timestep.setMaxSubsteps(settings.maxSubsteps);
+        resize(settings.layers);
+        m_cacheLayers.assign(m_layers.size(), FabricLayerSnapshot());
+        m_cacheFrame = 0;
+        return true;
+    }
+
+    // Back to simulating, from the start
+    void stopPlayback() {
+        if (m_cache.isOpen()) {
+            m_cache.close();
+            rebuild();
+        }
+    }
+
+    bool isPlayingBack() const {
+        return m_cache.isOpen();
+    }
+
+    uint64_t getPlaybackFrame() const {
+        return m_cacheFrame;
+    }
+
+    uint64_t getPlaybackFrameCount() const {
+        return m_cache.isOpen() ? m_cache.getFrameCount() : 0;
+    }
+
+    // Jumps to any step of the cache and starts timing from there
+    void seek(int64_t frame) {
+        if (m_cache.isOpen()) {
+            const int64_t last = static_cast<int64_t>(m_cache.getFrameCount()) - 1;
+            m_cacheFrame = static_cast<uint64_t>(std::max<int64_t>(0, std::min(frame, last)));
+            m_timestep.reset();
+        }
+    }
+
+    // Runs as many fixed physics steps as the frame time covers, keeping
+    // the state before the last one to interpolate from when drawing
+    void advance(float frameSeconds, sf::Vector2f mousePosition) {
+        if (m_cache.isOpen()) {
+            // The leftover time carries over, as when simulating, so the
+            // frames between steps interpolate
+            const uint64_t last = m_cache.getFrameCount() - 1;
+            m_cacheFrame = std::min(last, m_cacheFrame + static_cast<uint64_t>(m_timestep.advance(frameSeconds)));
+            return;
+        }
+        if (m_recorder.isOpen()) {
+            if (m_recorder.getSettings() != getSettings()) {
+                std::cerr << "Fabric: settings changed; recording stopped after " << m_recorder.getFrameCount()
+                          << " frames" << std::endl;
+                m_recorder.close();
+            } else {
+                m_recorder.write({frameSeconds, mousePosition.x, mousePosition.y});
+            }
+        }
+        if (m_physicsRunning) {
+            // A full queue only means the thread is behind; it steps with
+            // the newest position it has
+            m_mouseInput.push(mousePosition);
+            return;
+        }
+        int steps = m_timestep.advance(frameSeconds);
+        for (int i = 0; i < steps; ++i) {
+            if (i == steps - 1) {
+                savePreviousState();
+            }
+            update(m_timestep.getStep(), mousePosition);
+        }
+    }
+
+    // Rate changes reach a running physics thread when it restarts
+    FixedTimestep& getTimestep() {
+        return m_timestep;
+    }
+
+    const FixedTimestep& getTimestep() const {
+        return m_timestep;
+    }
+
+    // One physics step. Each layer feels the mouse from further back in
+    // its history, and a little more weakly, than the one above it.
+    void update(float deltaTime, sf::Vector2f mousePosition) {
+        m_rebuilt = false;
+        // Store current mouse position in history
+        m_mouseHistory.push_back(mousePosition);
+        if (m_mouseHistory.size() > MOUSE_HISTORY_SIZE) {
+            m_mouseHistory.pop_front();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < getLayerCount(); ++i) {
+            int delayIndex = std::max(0, static_cast<int>(m_mouseHistory.size()) - 1 - i);
+            float forceMultiplier = 1.0f - (i * 0.15f / m_layers.size());
+            sf::Vector2f position = m_mouseHistory[delayIndex];
+            verlet::MouseForce mouse = {position.x, position.y, MOUSE_FORCE_RADIUS,
+                                        MOUSE_FORCE_STRENGTH * forceMultiplier * deltaTime};
+            // Only the nodes near the brush; the boxes are from the last
+            // integration, and a constraint pass rarely moves a node a cell
+            m_index.query(mouse.x, mouse.y, mouse.radius, m_grid.cellSize, i * m_grid.height, (i + 1) * m_grid.height,
+                          [&](size_t begin, size_t end) { verlet::applyMouseForce(m_nodes, begin, end, mouse); });
+        }
+
+        const float gravityStep = GRAVITY * deltaTime;
+        if (m_solverMode == SOLVER_XPBD) {
+            // The same acceleration and damping per step as in PBD mode,
+            // spread over the substeps
+            const float substep = deltaTime / m_substeps;
+            const float damping = std::pow(DAMPING_FACTOR, 1.0f / m_substeps);
+            m_residuals.clear();
+            for (int i = 0; i < m_substeps; ++i) {
+                integrate(damping, gravityStep / (m_substeps * m_substeps));
+                if (m_multigridLevels > 0) {
+                    m_multigrid.solve(m_nodes, &m_pool);
+                }
+                if (m_solver.solveCompliant(m_nodes, 1, substep, &m_pool) > 0) {
+                    unlinkTorn();
+                }
+                m_residuals.insert(m_residuals.end(), m_solver.getResiduals().begin(),
+                                   m_solver.getResiduals().end());
+            }
+        } else {
+            integrate(DAMPING_FACTOR, gravityStep);
+            if (m_multigridLevels > 0) {
+                m_multigrid.solve(m_nodes, &m_pool);
+            }
+            if (m_solver.solve(m_nodes, m_iterations, &m_pool) > 0) {
+                unlinkTorn();
+            }
+            m_residuals = m_solver.getResiduals();
+        }
+
+        double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        m_stepMilliseconds = 0.9f * m_stepMilliseconds + 0.1f * static_cast<float>(wall * 1000.0);
+
+        if (m_cacheWriter.isOpen()) {
+            appendCacheFrame();
+        }
+    }
+
+    int getThreadCount() const {
+        return m_pool.size();
+    }
+
+    // Smoothed wall time of a physics step
+    float getStepMilliseconds() const {
+        return m_physicsRunning ? m_snapshots.read().stepMilliseconds : m_stepMilliseconds;
+    }
+
+    // Node position to draw, alpha of the way from the saved state to the
+    // current one
+    sf::Vector2f getRenderPosition(int index, float alpha) const {
+        return sf::Vector2f(m_previousX[index] + (m_nodes.x[index] - m_previousX[index]) * alpha,
+                            m_previousY[index] + (m_nodes.y[index] - m_previousY[index]) * alpha);
+    }
+
+    void draw(sf::RenderTarget& target) {
+        if (m_cache.isOpen()) {
+            drawCached(target);
+            return;
+        }
+        if (m_physicsRunning) {
+            m_snapshots.update();
+            const FabricSnapshot& snapshot = m_snapshots.read();
+            auto position = [&](int index) { return sf::Vector2f(snapshot.x[index], snapshot.y[index]); };
+            for (size_t i = 0; i < m_layers.size(); ++i) {
+                m_layers[i].draw(target, snapshot.layers[i], position);
+            }
+            drawInterLayerConnections(target, position);
+            return;
+        }
+
+        const float alpha = m_timestep.getAlpha();
+        auto position = [&](int index) { return getRenderPosition(index, alpha); };
+        for (auto& layer : m_layers) {
+            layer.draw(target, position);
+        }
+        drawInterLayerConnections(target, position);
+    }
+
+private:
+    FabricGrid m_grid;
+    std::vector<FabricLayer> m_layers;
+    NodeArrays m_nodes;
+    ConstraintSolver m_solver;
+    CoarseNodeIndex m_index;
+    std::vector<float> m_previousX;
+    std::vector<float> m_previousY;
+    // The springs between layers, as node pairs
+    std::vector<std::pair<int, int>> m_connections;
+    std::deque<sf::Vector2f> m_mouseHistory;
+    std::vector<sf::Color> m_palette;
+    ThreadPool m_pool;
+    FixedTimestep m_timestep;
+    bool m_curved;
+    float m_tearRatio;
+    int m_iterations;
+    int m_multigridLevels;
+    MultigridSolver m_multigrid;
+    SolverMode m_solverMode;
+    int m_substeps;
+    float m_compliance;
+    std::vector<float> m_residuals;
+    FabricInputRecorder m_recorder;
+    // Cache being written or played back, and the links of the frame last
+    // written or drawn
+    FabricCacheWriter m_cacheWriter;
+    FabricCacheReader m_cache;
+    uint64_t m_cacheFrame = 0;
+    std::vector<FabricLayerSnapshot> m_cacheLayers;
+    // Nothing has stepped since the last rebuild
+    bool m_rebuilt = false;
+    float m_stepMilliseconds;
+
+    // Physics thread; the mouse positions go to it through m_mouseInput and
+    // its steps come back through m_snapshots
+    std::thread m_physicsThread;
+    std::atomic<bool> m_physicsRunning;
+    SpscQueue<sf::Vector2f> m_mouseInput;
+    TripleBuffer<FabricSnapshot> m_snapshots;
+
+    void resize(int layerCount) {
+        layerCount = std::max(1, layerCount);
+        float spacing = LAYER_DEPTH_OFFSET * std::min(1.0f, (NUM_LAYERS - 1) / std::max(1.0f, layerCount - 1.0f));
+        m_layers.clear();
+        m_layers.reserve(layerCount);
+        for (int i = 0; i < layerCount; ++i) {
+            m_layers.emplace_back(i, i * spacing, m_palette, m_grid);
+            if (m_curved) {
+                m_layers.back().setCurved(true);
+            }
+        }
+        rebuild();
+    }
+
+    // Lays the layers out afresh in the pool, one below the other, so the
+    // pool is a width x (layers * height) lattice for the index
+    void rebuild() {
+        if (m_recorder.isOpen()) {
+            std::cerr << "Fabric: rebuilt; recording stopped after " << m_recorder.getFrameCount() << " frames"
+                      << std::endl;
+            m_recorder.close();
+        }
+        if (m_cacheWriter.isOpen()) {
+            std::cerr << "Fabric: rebuilt; caching stopped after " << m_cacheWriter.getFrameCount() << " frames"
+                      << std::endl;
+            m_cacheWriter.close();
+        }
+        m_nodes.clear();
+        m_solver.clear();
+        for (auto& layer : m_layers) {
+            layer.addNodes(m_nodes);
+        }
+        for (auto& layer : m_layers) {
+            layer.addConstraints(m_solver, m_nodes);
+        }
+        connectAllCorners();
+        m_solver.setCompliance(m_compliance);
+        buildMultigrid();
+
+        m_index.build(m_grid.width, m_grid.height * getLayerCount());
+        m_index.refresh(m_nodes);
+        m_mouseHistory.clear();
+        m_timestep.reset();
+        savePreviousState();
+        m_rebuilt = true;
+    }
+
+    // Rebuilds unless nothing has stepped since the last rebuild, so that a
+    // recording and a cache started together both begin from it
+    void startOver() {
+        if (!m_rebuilt) {
+            rebuild();
+        }
+    }
+
+    // Springs from each corner to the same corner of the next layer, at
+    // the layers' spacing. The first layer's corners are pinned; the
+    // others hang from them, and from the top border like every layer.
+    void connectAllCorners() {
+        m_connections.clear();
+        for (int index : m_grid.corners()) {
+            m_nodes.setPinned(index, true);
+            for (int i = 0; i + 1 < getLayerCount(); ++i) {
+                int a = m_layers[i].getFirst() + index;
+                int b = m_layers[i + 1].getFirst() + index;
+                m_solver.add(FabricLayer::makeConstraint(m_nodes, a, b, true));
+                m_connections.emplace_back(a, b);
+            }
+        }
+    }
+
+    // Verlet step of every node, in bands of rows per thread; small pools
+    // are not worth waking the threads for, as with the solver
+    void integrate(float damping, float gravityStep) {
+        if (m_pool.size() > 1 && m_nodes.size() >= ConstraintSolver::PARALLEL_THRESHOLD) {
+            m_pool.run([&](int worker, int workers) {
+                auto rows = ThreadPool::split(m_index.getHeight(), worker, workers);
+                m_index.integrate(m_nodes, damping, gravityStep, static_cast<int>(rows.first),
+                                  static_cast<int>(rows.second));
+            });
+        } else {
+            m_index.integrate(m_nodes, damping, gravityStep);
+        }
+    }
+
+    // Coarse levels over each layer's grid, spanning intact threads only
+    void buildMultigrid() {
+        m_multigrid.build(m_grid.width, m_grid.height, getLayerCount(), m_grid.cellSize, m_nodes, m_multigridLevels,
+                          [&](int index, bool horizontal) {
+                              return m_layers[index / m_grid.nodeCount()].isLinked(index, horizontal);
+                          });
+    }
+
+    // Keeps the current positions to draw from while the next step runs
+    void savePreviousState() {
+        m_previousX = m_nodes.x;
+        m_previousY = m_nodes.y;
+    }
+
+    void unlinkTorn() {
+        for (const auto& constraint : m_solver.getTorn()) {
+            int a = std::min(constraint.nodeAIndex, constraint.nodeBIndex);
+            int b = std::max(constraint.nodeAIndex, constraint.nodeBIndex);
+            m_layers[a / m_grid.nodeCount()].unlink(a, b);
+            m_multigrid.unlink(a, b == a + 1);
+        }
+    }
+
+    // position(index) is where to draw a node of the pool
+    template <typename Position>
+    void drawInterLayerConnections(sf::RenderTarget& target, Position position) {
+        sf::VertexArray vertices(sf::Lines);
+
+        for (const auto& connection : m_connections) {
+            sf::Color connectionColor = m_palette[(connection.second / m_grid.nodeCount()) % m_palette.size()];
+            connectionColor.a = 150; // Semi-transparent
+
+            vertices.append(sf::Vertex(position(connection.first), connectionColor));
+            vertices.append(sf::Vertex(position(connection.second), connectionColor));
+        }
+
+        target.draw(vertices);
+    }
+
+    void appendCacheFrame() {
+        m_cacheLayers.resize(m_layers.size());
+        for (size_t i = 0; i < m_layers.size(); ++i) {
+            m_layers[i].capture(m_cacheLayers[i]);
+        }
+        m_cacheWriter.append(m_nodes.x.data(), m_nodes.y.data(), m_cacheLayers);
+    }
+
+    // The playback frame, alpha of the way from the one before, with the
+    // links it was written with; the last frame is held still
+    void drawCached(sf::RenderTarget& target) {
+        const uint64_t last = m_cache.getFrameCount() - 1;
+        const FabricCacheFrame current = m_cache.frame(m_cacheFrame);
+        const FabricCacheFrame previous = m_cache.frame(m_cacheFrame > 0 ? m_cacheFrame - 1 : 0);
+        const float alpha = m_cacheFrame < last ? m_timestep.getAlpha() : 1.0f;
+        auto position = [&](int index) {
+            sf::Vector2f from = previous.position(index);
+            return from + (current.position(index) - from) * alpha;
+        };
+
+        const size_t perLayer = m_grid.nodeCount();
+        for (size_t i = 0; i < m_layers.size(); ++i) {
+            FabricLayerSnapshot& snapshot = m_cacheLayers[i];
+            const uint32_t torn = current.getTornCount(static_cast<uint32_t>(i));
+            if (snapshot.tornCount != torn || snapshot.links.size() != perLayer) {
+                const uint8_t* links = current.getLinks() + i * perLayer;
+                snapshot.links.assign(links, links + perLayer);
+                snapshot.tornCount = torn;
+            }
+            m_layers[i].draw(target, snapshot, position);
+        }
+        drawInterLayerConnections(target, position);
+    }
+
+    template <typename Change>
+    void whilePaused(Change change) {
+        bool threaded = m_physicsRunning;
+        stopPhysicsThread();
+        change();
+        if (threaded) {
+            startPhysicsThread();
+        }
+    }
+
+    // The physics thread: steps on a fixed schedule, taking the newest
+    // mouse position queued, and publishes each step. After a hitch it
+    // skips ahead rather than running a burst of catch-up steps.
+    void runPhysics() {
+        const float step = m_timestep.getStep();
+        const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(step));
+        const auto maxLag = interval * m_timestep.getMaxSubsteps();
+        sf::Vector2f mousePosition = m_mouseHistory.empty() ? sf::Vector2f() : m_mouseHistory.back();
+        uint64_t steps = 0;
+        auto next = std::chrono::steady_clock::now();
+        while (m_physicsRunning.load(std::memory_order_acquire)) {
+            sf::Vector2f queued;
+            while (m_mouseInput.pop(queued)) {
+                mousePosition = queued;
+            }
+            update(step, mousePosition);
+            publishSnapshot(++steps);
+
+            next += interval;
+            auto now = std::chrono::steady_clock::now();
+            if (now - next > maxLag) {
+                next = now;
+            }
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    void publishSnapshot(uint64_t steps) {
+        FabricSnapshot& snapshot = m_snapshots.write();
+        snapshot.x = m_nodes.x;
+        snapshot.y = m_nodes.y;
+        snapshot.layers.resize(m_layers.size());
+        for (size_t i = 0; i < m_layers.size(); ++i) {
+            m_layers[i].capture(snapshot.layers[i]);
+        }
+        snapshot.steps = steps;
+        snapshot.stepMilliseconds = m_stepMilliseconds;
+        snapshot.residual = m_residuals.empty() ? 0.0f : m_residuals.back();
+        m_snapshots.publish();
+    }
+};
+
+#endif // FABRIC_HPP
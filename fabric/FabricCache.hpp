@@ -0,0 +1,414 @@
+#ifndef FABRIC_CACHE_HPP
+#define FABRIC_CACHE_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "FabricRecording.hpp"
+#include "../lib/FrameSpool.hpp"
+
+// On-disk layout of a fabric simulation cache:
+//
+//   [FabricCacheHeader, padded to one page][chunk 0][chunk 1]...
+//
+// A chunk is chunkFrames frames, padded to a page boundary so that the
+// writer can map one chunk at a time. A frame is one physics step:
+//
+//   [FabricCacheFrameInfo][torn count per layer][x per node][y per node]
+//   [link bits per node]
+//
+// Positions are floats, or with QUANTIZED set 16-bit fixed point over the
+// frame's bounding box (origin + value * scale), which halves them and
+// keeps them within a 65535th of the cloth's extent.
+struct FabricCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t layers;
+    uint32_t nodeCount;
+    uint32_t frameStride;
+    uint32_t chunkFrames;
+    uint64_t frameCount;
+    FabricSettings settings;
+};
+
+struct FabricCacheFrameInfo {
+    float originX;
+    float originY;
+    float scaleX;
+    float scaleY;
+};
+
+namespace fabriccache {
+    constexpr char MAGIC[8] = {'G', 'A', 'F', 'C', 'A', 'C', 'H', 'E'};
+    constexpr uint32_t VERSION = 1;
+    constexpr uint32_t QUANTIZED = 1;
+    // Chunks are about this big, or one frame if frames are bigger
+    constexpr size_t CHUNK_BYTES = 8 * 1024 * 1024;
+
+    // Alignment within a frame; whole pages use spool::roundToPage
+    inline size_t roundTo(size_t bytes, size_t alignment) {
+        return (bytes + alignment - 1) / alignment * alignment;
+    }
+
+    inline size_t dataOffset() {
+        return spool::roundToPage(sizeof(FabricCacheHeader));
+    }
+
+    // Where each part of a frame starts
+    struct Layout {
+        size_t torn;
+        size_t x;
+        size_t y;
+        size_t links;
+        size_t stride;
+
+        Layout(uint32_t layers, uint32_t nodeCount, bool quantized) {
+            const size_t positionBytes = static_cast<size_t>(nodeCount) * (quantized ? 2 : 4);
+            torn = sizeof(FabricCacheFrameInfo);
+            x = roundTo(torn + layers * sizeof(uint32_t), 8);
+            y = roundTo(x + positionBytes, 8);
+            links = roundTo(y + positionBytes, 8);
+            stride = roundTo(links + nodeCount, 64);
+        }
+    };
+
+    inline size_t chunkStride(const FabricCacheHeader& header) {
+        return spool::roundToPage(static_cast<size_t>(header.chunkFrames) * header.frameStride);
+    }
+
+    inline size_t frameOffset(const FabricCacheHeader& header, uint64_t frame) {
+        return dataOffset() + static_cast<size_t>(frame / header.chunkFrames) * chunkStride(header) +
+               static_cast<size_t>(frame % header.chunkFrames) * header.frameStride;
+    }
+}
+
+// Appends frames through a memory-mapped window of one chunk that moves
+// along the file, as FrameSpoolWriter does; finished chunks are left to
+// the kernel to write back. The frame count in the header is kept up to
+// date, so a cache cut short by a crash still reads.
+class FabricCacheWriter {
+public:
+    FabricCacheWriter()
+        : m_fd(-1), m_header(nullptr), m_window(nullptr), m_windowChunk(0), m_chunkStride(0), m_frameCount(0),
+          m_layout(0, 0, false) {}
+
+    ~FabricCacheWriter() {
+        close();
+    }
+
+    FabricCacheWriter(const FabricCacheWriter&) = delete;
+    FabricCacheWriter& operator=(const FabricCacheWriter&) = delete;
+
+    bool open(const std::string& path, const FabricSettings& settings, uint32_t layers, uint32_t nodeCount,
+              bool quantized) {
+        close();
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0) {
+            std::cerr << "Cache: could not open " << path << std::endl;
+            return false;
+        }
+
+        const size_t headerBytes = fabriccache::dataOffset();
+        if (ftruncate(m_fd, static_cast<off_t>(headerBytes)) != 0) {
+            close();
+            return false;
+        }
+        void* mapped = mmap(nullptr, headerBytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Cache: mmap failed" << std::endl;
+            close();
+            return false;
+        }
+
+        m_layout = fabriccache::Layout(layers, nodeCount, quantized);
+        m_header = static_cast<FabricCacheHeader*>(mapped);
+        std::memcpy(m_header->magic, fabriccache::MAGIC, sizeof(m_header->magic));
+        m_header->version = fabriccache::VERSION;
+        m_header->flags = quantized ? fabriccache::QUANTIZED : 0;
+        m_header->layers = layers;
+        m_header->nodeCount = nodeCount;
+        m_header->frameStride = static_cast<uint32_t>(m_layout.stride);
+        m_header->chunkFrames = static_cast<uint32_t>(std::max<size_t>(1, fabriccache::CHUNK_BYTES / m_layout.stride));
+        m_header->frameCount = 0;
+        m_header->settings = settings;
+        m_chunkStride = fabriccache::chunkStride(*m_header);
+        m_frameCount = 0;
+        return mapChunk(0);
+    }
+
+    bool isOpen() const {
+        return m_fd >= 0;
+    }
+
+    bool isQuantized() const {
+        return m_header && (m_header->flags & fabriccache::QUANTIZED);
+    }
+
+    // Safe to read from another thread than the one appending
+    uint64_t getFrameCount() const {
+        return m_frameCount.load(std::memory_order_relaxed);
+    }
+
+    // One step: nodeCount positions and, per layer, layers[i].links (one
+    // byte per node of the layer) and layers[i].tornCount
+    template <typename Layers>
+    bool append(const float* x, const float* y, const Layers& layers) {
+        if (!m_header) {
+            return false;
+        }
+        const uint64_t frame = m_header->frameCount;
+        const size_t chunk = static_cast<size_t>(frame / m_header->chunkFrames);
+        if (chunk != m_windowChunk) {
+            // Hand the finished chunk to the kernel for write-back
+            msync(m_window, m_chunkStride, MS_ASYNC);
+            if (!mapChunk(chunk)) {
+                close();
+                return false;
+            }
+        }
+
+        uint8_t* slot = m_window + static_cast<size_t>(frame % m_header->chunkFrames) * m_header->frameStride;
+        const size_t count = m_header->nodeCount;
+        FabricCacheFrameInfo info = {0.0f, 0.0f, 1.0f, 1.0f};
+        if (isQuantized()) {
+            quantize(x, count, reinterpret_cast<uint16_t*>(slot + m_layout.x), info.originX, info.scaleX);
+            quantize(y, count, reinterpret_cast<uint16_t*>(slot + m_layout.y), info.originY, info.scaleY);
+        } else {
+            std::memcpy(slot + m_layout.x, x, count * sizeof(float));
+            std::memcpy(slot + m_layout.y, y, count * sizeof(float));
+        }
+        std::memcpy(slot, &info, sizeof(info));
+
+        uint32_t* torn = reinterpret_cast<uint32_t*>(slot + m_layout.torn);
+        uint8_t* links = slot + m_layout.links;
+        const size_t perLayer = count / m_header->layers;
+        for (uint32_t i = 0; i < m_header->layers; ++i) {
+            torn[i] = static_cast<uint32_t>(layers[i].tornCount);
+            std::memcpy(links + i * perLayer, layers[i].links.data(), perLayer);
+        }
+
+        m_header->frameCount = frame + 1;
+        m_frameCount.store(frame + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void close() {
+        if (m_fd < 0) {
+            return;
+        }
+        size_t finalSize = fabriccache::dataOffset();
+        if (m_header && m_header->frameCount > 0) {
+            finalSize = fabriccache::frameOffset(*m_header, m_header->frameCount - 1) + m_header->frameStride;
+        }
+        unmapChunk();
+        if (m_header) {
+            msync(m_header, fabriccache::dataOffset(), MS_SYNC);
+            munmap(m_header, fabriccache::dataOffset());
+            m_header = nullptr;
+        }
+        // Drop the unused tail of the last chunk
+        if (ftruncate(m_fd, static_cast<off_t>(finalSize)) != 0) {
+            std::cerr << "Cache: could not trim file" << std::endl;
+        }
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+private:
+    int m_fd;
+    FabricCacheHeader* m_header;
+    uint8_t* m_window;
+    size_t m_windowChunk;
+    size_t m_chunkStride;
+    std::atomic<uint64_t> m_frameCount;
+    fabriccache::Layout m_layout;
+
+    void unmapChunk() {
+        if (m_window) {
+            munmap(m_window, m_chunkStride);
+            m_window = nullptr;
+        }
+    }
+
+    bool mapChunk(size_t chunk) {
+        unmapChunk();
+        const off_t offset = static_cast<off_t>(fabriccache::dataOffset() + chunk * m_chunkStride);
+        if (ftruncate(m_fd, offset + static_cast<off_t>(m_chunkStride)) != 0) {
+            std::cerr << "Cache: could not grow file (disk full?)" << std::endl;
+            return false;
+        }
+        void* mapped = mmap(nullptr, m_chunkStride, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, offset);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Cache: mmap failed" << std::endl;
+            return false;
+        }
+        m_window = static_cast<uint8_t*>(mapped);
+        m_windowChunk = chunk;
+        return true;
+    }
+
+    // 16-bit fixed point over [min, max] of the values
+    static void quantize(const float* values, size_t count, uint16_t* out, float& origin, float& scale) {
+        float low = count > 0 ? values[0] : 0.0f;
+        float high = low;
+        for (size_t i = 1; i < count; ++i) {
+            low = std::min(low, values[i]);
+            high = std::max(high, values[i]);
+        }
+        origin = low;
+        scale = high > low ? (high - low) / 65535.0f : 1.0f;
+        const float inverse = 1.0f / scale;
+        for (size_t i = 0; i < count; ++i) {
+            float value = (values[i] - low) * inverse + 0.5f;
+            out[i] = static_cast<uint16_t>(std::min(65535.0f, std::max(0.0f, value)));
+        }
+    }
+};
+
+// One frame of a cache, valid while the reader is open
+class FabricCacheFrame {
+public:
+    FabricCacheFrame(const uint8_t* data, const fabriccache::Layout& layout, bool quantized)
+        : m_data(data), m_layout(&layout), m_quantized(quantized) {
+        std::memcpy(&m_info, data, sizeof(m_info));
+    }
+
+    sf::Vector2f position(int index) const {
+        if (m_quantized) {
+            const uint16_t* x = reinterpret_cast<const uint16_t*>(m_data + m_layout->x);
+            const uint16_t* y = reinterpret_cast<const uint16_t*>(m_data + m_layout->y);
+            return sf::Vector2f(m_info.originX + x[index] * m_info.scaleX, m_info.originY + y[index] * m_info.scaleY);
+        }
+        const float* x = reinterpret_cast<const float*>(m_data + m_layout->x);
+        const float* y = reinterpret_cast<const float*>(m_data + m_layout->y);
+        return sf::Vector2f(x[index], y[index]);
+    }
+
+    uint32_t getTornCount(uint32_t layer) const {
+        uint32_t torn;
+        std::memcpy(&torn, m_data + m_layout->torn + layer * sizeof(uint32_t), sizeof(torn));
+        return torn;
+    }
+
+    // Link bits of every node, layer after layer
+    const uint8_t* getLinks() const {
+        return m_data + m_layout->links;
+    }
+
+private:
+    const uint8_t* m_data;
+    const fabriccache::Layout* m_layout;
+    bool m_quantized;
+    FabricCacheFrameInfo m_info;
+};
+
+// Read-only view of a cache. The whole file is mapped and pages are
+// faulted in on demand, so any frame can be drawn next at the cost of
+// reading it.
+class FabricCacheReader {
+public:
+    FabricCacheReader() : m_fd(-1), m_data(nullptr), m_size(0), m_header(), m_layout(0, 0, false) {}
+
+    ~FabricCacheReader() {
+        close();
+    }
+
+    FabricCacheReader(const FabricCacheReader&) = delete;
+    FabricCacheReader& operator=(const FabricCacheReader&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+        m_fd = ::open(path.c_str(), O_RDONLY);
+        if (m_fd < 0) {
+            std::cerr << "Cache: could not open " << path << std::endl;
+            return false;
+        }
+
+        off_t fileSize = lseek(m_fd, 0, SEEK_END);
+        if (fileSize < static_cast<off_t>(fabriccache::dataOffset())) {
+            std::cerr << "Cache: " << path << " is truncated" << std::endl;
+            close();
+            return false;
+        }
+
+        m_size = static_cast<size_t>(fileSize);
+        void* mapped = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Cache: mmap failed" << std::endl;
+            close();
+            return false;
+        }
+        m_data = static_cast<uint8_t*>(mapped);
+        std::memcpy(&m_header, m_data, sizeof(m_header));
+
+        if (std::memcmp(m_header.magic, fabriccache::MAGIC, sizeof(m_header.magic)) != 0 ||
+            m_header.version != fabriccache::VERSION || m_header.layers == 0 || m_header.chunkFrames == 0) {
+            std::cerr << "Cache: " << path << " is not a fabric cache" << std::endl;
+            close();
+            return false;
+        }
+
+        m_layout = fabriccache::Layout(m_header.layers, m_header.nodeCount, isQuantized());
+        // Writer did not shut down cleanly; keep the frames that made it to disk
+        while (m_header.frameCount > 0 &&
+               fabriccache::frameOffset(m_header, m_header.frameCount - 1) + m_header.frameStride > m_size) {
+            --m_header.frameCount;
+        }
+        return true;
+    }
+
+    void close() {
+        if (m_data) {
+            munmap(m_data, m_size);
+            m_data = nullptr;
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    bool isOpen() const {
+        return m_data != nullptr;
+    }
+
+    const FabricSettings& getSettings() const {
+        return m_header.settings;
+    }
+
+    bool isQuantized() const {
+        return (m_header.flags & fabriccache::QUANTIZED) != 0;
+    }
+
+    uint64_t getFrameCount() const {
+        return m_header.frameCount;
+    }
+
+    uint32_t getNodeCount() const {
+        return m_header.nodeCount;
+    }
+
+    // i < getFrameCount()
+    FabricCacheFrame frame(uint64_t i) const {
+        return FabricCacheFrame(m_data + fabriccache::frameOffset(m_header, i), m_layout, isQuantized());
+    }
+
+private:
+    int m_fd;
+    uint8_t* m_data;
+    size_t m_size;
+    FabricCacheHeader m_header;
+    fabriccache::Layout m_layout;
+};
+
+#endif // FABRIC_CACHE_HPP
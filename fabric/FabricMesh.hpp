@@ -0,0 +1,133 @@
+#ifndef FABRIC_MESH_HPP
+#define FABRIC_MESH_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstddef>
+
+// A run of nodes drawn as one polyline: count nodes from first, stride
+// apart (1 along a row, the grid width down a column)
+struct FabricStrip {
+    int first;
+    int stride;
+    int count;
+};
+
+// Line strips of one color, kept in an sf::VertexBuffer that is rewritten
+// in place each frame. All strips go into a single LineStrip draw: each is
+// wrapped in two transparent vertices, so the jumps between them are
+// invisible.
+//
+// With subdivisions above 1, each span between two nodes is drawn as that
+// many pieces of a Catmull-Rom curve through the neighbouring nodes.
+class FabricMesh {
+public:
+    FabricMesh() : m_buffer(sf::LineStrip, sf::VertexBuffer::Stream), m_subdivisions(1) {}
+
+    // Lays out the vertices and their colors; positions come from update()
+    void build(const std::vector<FabricStrip>& strips, sf::Color color, int subdivisions) {
+        m_strips = strips;
+        m_subdivisions = subdivisions < 1 ? 1 : subdivisions;
+
+        sf::Color joint = color;
+        joint.a = 0;
+        m_vertices.clear();
+        for (const auto& strip : m_strips) {
+            if (strip.count < 2) {
+                continue;
+            }
+            m_vertices.emplace_back(sf::Vector2f(), joint);
+            m_vertices.insert(m_vertices.end(), (strip.count - 1) * m_subdivisions + 1, sf::Vertex(sf::Vector2f(), color));
+            m_vertices.emplace_back(sf::Vector2f(), joint);
+        }
+
+        if (sf::VertexBuffer::isAvailable() && m_buffer.getVertexCount() != m_vertices.size()) {
+            m_buffer.create(m_vertices.size());
+        }
+    }
+
+    const std::vector<FabricStrip>& getStrips() const {
+        return m_strips;
+    }
+
+    int getSubdivisions() const {
+        return m_subdivisions;
+    }
+
+    size_t getVertexCount() const {
+        return m_vertices.size();
+    }
+
+    // Moves the vertices to position(node) for each node of each strip
+    template <typename Position>
+    void update(Position position) {
+        sf::Vertex* vertex = m_vertices.data();
+        for (const auto& strip : m_strips) {
+            if (strip.count < 2) {
+                continue;
+            }
+            sf::Vertex* begin = vertex + 1;
+            if (m_subdivisions == 1) {
+                for (int i = 0; i < strip.count; ++i) {
+                    begin[i].position = position(strip.first + i * strip.stride);
+                }
+            } else {
+                writeCurve(strip, position, begin);
+            }
+
+            size_t points = (strip.count - 1) * m_subdivisions + 1;
+            vertex[0].position = begin[0].position;
+            vertex[points + 1].position = begin[points - 1].position;
+            vertex += points + 2;
+        }
+
+        if (sf::VertexBuffer::isAvailable()) {
+            m_buffer.update(m_vertices.data());
+        }
+    }
+
+    void draw(sf::RenderTarget& target) const {
+        if (m_vertices.empty()) {
+            return;
+        }
+        if (sf::VertexBuffer::isAvailable()) {
+            target.draw(m_buffer);
+        } else {
+            target.draw(m_vertices.data(), m_vertices.size(), sf::LineStrip);
+        }
+    }
+
+private:
+    std::vector<FabricStrip> m_strips;
+    std::vector<sf::Vertex> m_vertices;
+    sf::VertexBuffer m_buffer;
+    int m_subdivisions;
+
+    // Uniform Catmull-Rom through the strip's nodes; the end nodes repeat
+    // as their own outer neighbours
+    template <typename Position>
+    void writeCurve(const FabricStrip& strip, Position position, sf::Vertex* out) const {
+        auto node = [&](int i) {
+            i = i < 0 ? 0 : (i >= strip.count ? strip.count - 1 : i);
+            return position(strip.first + i * strip.stride);
+        };
+
+        sf::Vector2f p0 = node(-1), p1 = node(0), p2 = node(1), p3 = node(2);
+        for (int i = 0; i + 1 < strip.count; ++i) {
+            for (int s = 0; s < m_subdivisions; ++s) {
+                float t = static_cast<float>(s) / m_subdivisions;
+                float t2 = t * t;
+                float t3 = t2 * t;
+                (out++)->position = 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+                                            (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+            }
+            p0 = p1;
+            p1 = p2;
+            p2 = p3;
+            p3 = node(i + 3);
+        }
+        out->position = p1;
+    }
+};
+
+#endif // FABRIC_MESH_HPP
@@ -0,0 +1,214 @@
+#ifndef FABRIC_RECORDING_HPP
+#define FABRIC_RECORDING_HPP
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// On-disk layout of a fabric input recording:
+//
+//   [FabricRecordingHeader][FabricInputFrame 0][FabricInputFrame 1]...
+//
+// The header holds the settings every step depends on; each frame, the
+// time and mouse position one advance() was given. Frames replayed into a
+// fabric rebuilt with the same settings repeat every step bit for bit, on
+// any number of threads. Only a fabric stepped on its physics thread
+// drifts from its recording, since it steps by the wall clock.
+struct FabricSettings {
+    int32_t gridWidth;
+    int32_t gridHeight;
+    int32_t layers;
+    float physicsHz;
+    int32_t maxSubsteps;
+    float tearRatio;
+    int32_t iterations;
+    int32_t multigridLevels;
+    int32_t solverMode;
+    int32_t substeps;
+    float compliance;
+
+    bool operator==(const FabricSettings& other) const {
+        return std::memcmp(this, &other, sizeof(FabricSettings)) == 0;
+    }
+
+    bool operator!=(const FabricSettings& other) const {
+        return !(*this == other);
+    }
+};
+
+struct FabricInputFrame {
+    float deltaTime;
+    float mouseX;
+    float mouseY;
+};
+
+// frameCount is 0 until the recorder is closed
+struct FabricRecordingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t frameCount;
+    FabricSettings settings;
+};
+
+namespace fabricrecording {
+    constexpr char MAGIC[8] = {'G', 'A', 'F', 'I', 'N', 'P', 'U', 'T'};
+    constexpr uint32_t VERSION = 1;
+}
+
+// Appends frames through a buffered file; twelve bytes each, so an hour at
+// 60 fps is about 2.5 MB
+class FabricInputRecorder {
+public:
+    FabricInputRecorder() : m_file(nullptr), m_frameCount(0) {}
+
+    ~FabricInputRecorder() {
+        close();
+    }
+
+    FabricInputRecorder(const FabricInputRecorder&) = delete;
+    FabricInputRecorder& operator=(const FabricInputRecorder&) = delete;
+
+    bool open(const std::string& path, const FabricSettings& settings) {
+        close();
+        m_file = std::fopen(path.c_str(), "wb");
+        if (!m_file) {
+            std::cerr << "Recording: could not open " << path << std::endl;
+            return false;
+        }
+        std::memset(&m_header, 0, sizeof(m_header));
+        std::memcpy(m_header.magic, fabricrecording::MAGIC, sizeof(m_header.magic));
+        m_header.version = fabricrecording::VERSION;
+        m_header.settings = settings;
+        m_frameCount = 0;
+        if (std::fwrite(&m_header, sizeof(m_header), 1, m_file) != 1) {
+            std::cerr << "Recording: could not write " << path << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    bool isOpen() const {
+        return m_file != nullptr;
+    }
+
+    const FabricSettings& getSettings() const {
+        return m_header.settings;
+    }
+
+    uint64_t getFrameCount() const {
+        return m_frameCount;
+    }
+
+    bool write(const FabricInputFrame& frame) {
+        if (!m_file) {
+            return false;
+        }
+        if (std::fwrite(&frame, sizeof(frame), 1, m_file) != 1) {
+            std::cerr << "Recording: write failed (disk full?)" << std::endl;
+            close();
+            return false;
+        }
+        ++m_frameCount;
+        return true;
+    }
+
+    // Fills in the frame count
+    void close() {
+        if (!m_file) {
+            return;
+        }
+        m_header.frameCount = m_frameCount;
+        if (std::fseek(m_file, 0, SEEK_SET) != 0 || std::fwrite(&m_header, sizeof(m_header), 1, m_file) != 1) {
+            std::cerr << "Recording: could not finish the header" << std::endl;
+        }
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+private:
+    std::FILE* m_file;
+    FabricRecordingHeader m_header;
+    uint64_t m_frameCount;
+};
+
+// A whole recording in memory, read back one frame at a time
+class FabricInputReplay {
+public:
+    FabricInputReplay() : m_position(0) {}
+
+    // A recording that was never closed (the program crashed) still plays
+    // every whole frame that reached the file
+    bool load(const std::string& path) {
+        m_frames.clear();
+        m_position = 0;
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            std::cerr << "Replay: could not open " << path << std::endl;
+            return false;
+        }
+        FabricRecordingHeader header;
+        if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+            std::memcmp(header.magic, fabricrecording::MAGIC, sizeof(header.magic)) != 0) {
+            std::cerr << "Replay: " << path << " is not a fabric recording" << std::endl;
+            std::fclose(file);
+            return false;
+        }
+        if (header.version != fabricrecording::VERSION) {
+            std::cerr << "Replay: " << path << " has unsupported version " << header.version << std::endl;
+            std::fclose(file);
+            return false;
+        }
+        FabricInputFrame frame;
+        while (std::fread(&frame, sizeof(frame), 1, file) == 1) {
+            m_frames.push_back(frame);
+        }
+        std::fclose(file);
+        if (header.frameCount != m_frames.size()) {
+            std::cerr << "Replay: " << path << " was not closed; playing its " << m_frames.size() << " frames"
+                      << std::endl;
+        }
+        m_settings = header.settings;
+        return true;
+    }
+
+    bool isLoaded() const {
+        return !m_frames.empty();
+    }
+
+    const FabricSettings& getSettings() const {
+        return m_settings;
+    }
+
+    size_t getFrameCount() const {
+        return m_frames.size();
+    }
+
+    size_t getPosition() const {
+        return m_position;
+    }
+
+    // The next frame; false once they have all been played
+    bool next(FabricInputFrame& frame) {
+        if (m_position >= m_frames.size()) {
+            return false;
+        }
+        frame = m_frames[m_position++];
+        return true;
+    }
+
+    void rewind() {
+        m_position = 0;
+    }
+
+private:
+    std::vector<FabricInputFrame> m_frames;
+    FabricSettings m_settings;
+    size_t m_position;
+};
+
+#endif // FABRIC_RECORDING_HPP
@@ -0,0 +1,306 @@
+#ifndef FABRIC_SKETCH_HPP
+#define FABRIC_SKETCH_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <iomanip>
+#include "Fabric.hpp"
+#include "../lib/Sketch.hpp"
+
+// The fabric layers push away from the mouse. Without one (headless
+// renders), the mouse follows a fixed Lissajous path across the grid, so
+// the same options always produce the same frames. Options:
+//
+//   --grid WxH (or N)      nodes across and down, up to 4096 (default: fits
+//                          the window)
+//   --layers N             number of layers; Up/Down change it live
+//   --threads N            threads the layers step on (default: all)
+//   --physics-hz HZ        fixed physics rate (default 60), drawn
+//                          interpolated between the last two steps
+//   --max-substeps N       physics steps per frame at most (default 4)
+//   --curves on            draw threads as curves through the nodes (C)
+//   --tear RATIO           threads tear past RATIO times their length (T);
+//                          R mends them
+//   --physics-thread on    step on a thread of its own at --physics-hz,
+//                          whatever the frame rate; not reproducible (P)
+//   --iterations N         solver passes per step
+//   --multigrid LEVELS     coarse corrections before the passes, which keep
+//                          big grids taut with a pass or two (M)
+//   --solver xpbd          XPBD solver, one pass per substep (X)
+//   --substeps N           XPBD substeps per step (default 10)
+//   --compliance C         XPBD thread stretchiness (default 0, inextensible)
+//   --record PATH          save the frame times and mouse positions
+//   --replay PATH          step with a saved recording, under its settings
+//   --cache PATH           write every physics step's nodes to a cache
+//   --cache-quantize on    store the cached nodes in 16 bits
+//   --playback PATH        draw a cache instead of simulating; Space pauses,
+//                          Left/Right jump a second
+class FabricSketch : public Sketch {
+private:
+    std::string paletteName;
+    std::vector<sf::Color> palette;
+    FabricInputReplay replay;
+    FabricGrid grid;
+    MultiLayerFabricSimulation fabric;
+    float time;
+    bool paused;
+    float tearRatio;
+    int multigridLevels;
+
+public:
+    static constexpr const char* NAME = "fabric";
+    static constexpr const char* DESCRIPTION = "Layered cloth pushed around by the mouse";
+
+    explicit FabricSketch(SketchResources& resources)
+        : paletteName(resources.getPaletteName()), palette(getPalette(paletteName)),
+          replay(loadReplay(resources.argument("--replay"))),
+          grid(initialGrid(resources)),
+          fabric(palette,
+                 std::max(1, std::atoi(resources.argument("--layers", std::to_string(NUM_LAYERS)).c_str())),
+                 static_cast<unsigned int>(std::max(0, std::atoi(resources.argument("--threads", "0").c_str()))), grid),
+          time(0.0f), paused(false),
+          tearRatio(static_cast<float>(std::atof(resources.argument("--tear", "0").c_str()))),
+          multigridLevels(std::atoi(resources.argument("--multigrid", "0").c_str())) {
+        fabric.getTimestep().setRate(static_cast<float>(std::atof(resources.argument("--physics-hz", "60").c_str())));
+        fabric.getTimestep().setMaxSubsteps(std::atoi(resources.argument("--max-substeps", "4").c_str()));
+        fabric.setCurved(resources.argument("--curves", "off") == "on");
+        fabric.setTearRatio(tearRatio);
+        fabric.setIterations(
+            std::atoi(resources.argument("--iterations", std::to_string(PHYSICS_ITERATIONS)).c_str()));
+        fabric.setMultigridLevels(multigridLevels);
+        fabric.setSolverMode(resources.argument("--solver", "pbd") == "xpbd" ? SOLVER_XPBD : SOLVER_PBD);
+        fabric.setSubsteps(std::atoi(resources.argument("--substeps", std::to_string(XPBD_SUBSTEPS)).c_str()));
+        fabric.setCompliance(static_cast<float>(std::atof(resources.argument("--compliance", "0").c_str())));
+        if (multigridLevels <= 0) {
+            multigridLevels = MULTIGRID_LEVELS;
+        }
+        if (tearRatio <= 0.0f) {
+            tearRatio = TEAR_RATIO;
+        }
+        std::string playback = resources.argument("--playback");
+        if (!playback.empty() && fabric.startPlayback(playback)) {
+            resources.getOptions().log() << "Playing " << fabric.getPlaybackFrameCount() << " cached steps." << std::endl;
+            return;
+        }
+        if (replay.isLoaded()) {
+            // Stepped on this thread, or the frames would not repeat
+            fabric.applySettings(replay.getSettings());
+            resources.getOptions().log() << "Replaying " << replay.getFrameCount() << " frames." << std::endl;
+        } else {
+            if (resources.argument("--physics-thread", "off") == "on") {
+                fabric.startPhysicsThread();
+            }
+            std::string recording = resources.argument("--record");
+            if (!recording.empty() && fabric.startRecording(recording)) {
+                resources.getOptions().log() << "Recording to " << recording << "." << std::endl;
+            }
+        }
+        std::string cache = resources.argument("--cache");
+        if (!cache.empty() && fabric.startCaching(cache, resources.argument("--cache-quantize", "off") == "on")) {
+            resources.getOptions().log() << "Caching to " << cache << "." << std::endl;
+        }
+    }
+
+    // The grid of the recording or cache being played, or --grid
+    FabricGrid initialGrid(const SketchResources& resources) const {
+        if (replay.isLoaded()) {
+            return FabricGrid::fitted(replay.getSettings().gridWidth, replay.getSettings().gridHeight);
+        }
+        std::string playback = resources.argument("--playback");
+        if (!playback.empty()) {
+            FabricCacheReader cache;
+            if (cache.open(playback)) {
+                return FabricGrid::fitted(cache.getSettings().gridWidth, cache.getSettings().gridHeight);
+            }
+        }
+        return parseGrid(resources.argument("--grid"));
+    }
+
+    // Empty if there is no path or it cannot be read
+    static FabricInputReplay loadReplay(const std::string& path) {
+        FabricInputReplay replay;
+        if (!path.empty()) {
+            replay.load(path);
+        }
+        return replay;
+    }
+
+    // "WxH" or "N" for a square grid; the default grid if empty
+    static FabricGrid parseGrid(const std::string& value) {
+        if (value.empty()) {
+            return FabricGrid();
+        }
+        int width = std::atoi(value.c_str());
+        size_t separator = value.find('x');
+        int height = separator == std::string::npos ? width : std::atoi(value.c_str() + separator + 1);
+        return FabricGrid::fitted(width, height);
+    }
+
+    sf::Vector2u getSize() const override {
+        // Room below the grid for the overlay
+        return sf::Vector2u(static_cast<unsigned int>(grid.width * grid.cellSize),
+                            static_cast<unsigned int>(grid.height * grid.cellSize) + 100);
+    }
+
+    void reset() override {
+        if (fabric.isPlayingBack()) {
+            fabric.seek(0);
+            return;
+        }
+        fabric.initialize();
+        replay.rewind();
+        time = 0.0f;
+        std::cout << "Fabric simulation reset." << std::endl;
+    }
+
+    void update(float deltaTime, const SketchInput& input) override {
+        if (fabric.isPlayingBack()) {
+            fabric.advance(paused ? 0.0f : deltaTime, input.mouse);
+            return;
+        }
+        if (replay.isLoaded()) {
+            FabricInputFrame frame;
+            if (replay.next(frame)) {
+                fabric.advance(frame.deltaTime, sf::Vector2f(frame.mouseX, frame.mouseY));
+            }
+            return;
+        }
+        time += deltaTime;
+        sf::Vector2f mousePosition = input.mouse;
+        if (!input.hasMouse) {
+            const float width = grid.width * grid.cellSize;
+            const float height = grid.height * grid.cellSize;
+            mousePosition = sf::Vector2f(width * (0.5f + 0.35f * std::sin(time * 0.7f)),
+                                         height * (0.5f + 0.35f * std::sin(time * 1.1f)));
+        }
+        fabric.advance(deltaTime, mousePosition);
+    }
+
+    bool handleEvent(const sf::Event& event) override {
+        if (event.type != sf::Event::KeyPressed) {
+            return false;
+        }
+        if (fabric.isPlayingBack()) {
+            const int64_t second = static_cast<int64_t>(fabric.getTimestep().getRate() + 0.5f);
+            const int64_t frame = static_cast<int64_t>(fabric.getPlaybackFrame());
+            if (event.key.code == sf::Keyboard::Space) {
+                paused = !paused;
+                return true;
+            }
+            if (event.key.code == sf::Keyboard::Left) {
+                fabric.seek(frame - second);
+                return true;
+            }
+            if (event.key.code == sf::Keyboard::Right) {
+                fabric.seek(frame + second);
+                return true;
+            }
+        }
+        if (event.key.code == sf::Keyboard::Up) {
+            fabric.setLayerCount(fabric.getLayerCount() + 1);
+            return true;
+        }
+        if (event.key.code == sf::Keyboard::Down && fabric.getLayerCount() > 1) {
+            fabric.setLayerCount(fabric.getLayerCount() - 1);
+            return true;
+        }
+        if (event.key.code == sf::Keyboard::C) {
+            fabric.setCurved(!fabric.isCurved());
+            return true;
+        }
+        if (event.key.code == sf::Keyboard::P) {
+            if (fabric.isPhysicsThreaded()) {
+                fabric.stopPhysicsThread();
+            } else {
+                fabric.startPhysicsThread();
+            }
+            return true;
+        }
+        if (event.key.code == sf::Keyboard::M) {
+            fabric.setMultigridLevels(fabric.getMultigridLevels() > 0 ? 0 : multigridLevels);
+            return true;
+        }
+        if (event.key.code == sf::Keyboard::X) {
+            fabric.setSolverMode(fabric.getSolverMode() == SOLVER_XPBD ? SOLVER_PBD : SOLVER_XPBD);
+            return true;
+        }
+        if (event.key.code == sf::Keyboard::T) {
+            fabric.setTearRatio(fabric.getTearRatio() > 0.0f ? 0.0f : tearRatio);
+            return true;
+        }
+        return false;
+    }
+
+    void draw(sf::RenderTarget& target) override {
+        target.clear(sf::Color::Black);
+        fabric.draw(target);
+    }
+
+    std::string getHelp() const override {
+        if (fabric.isPlayingBack()) {
+            return "Space: Pause | Left/Right: Seek 1 s | C: Curves (" + std::string(fabric.isCurved() ? "on" : "off") +
+                   ")";
+        }
+        return "Up/Down: Layers | C: Curves (" + std::string(fabric.isCurved() ? "on" : "off") + ") | T: Tearing (" +
+               std::string(fabric.getTearRatio() > 0.0f ? "on" : "off") + ") | M: Multigrid (" +
+               std::string(fabric.getMultigridLevels() > 0 ? "on" : "off") + ") | X: XPBD (" +
+               std::string(fabric.getSolverMode() == SOLVER_XPBD ? "on" : "off") + ") | P: Physics thread (" +
+               std::string(fabric.isPhysicsThreaded() ? "on" : "off") + ")";
+    }
+
+    std::string getStatus() const override {
+        std::stringstream status;
+        status << std::fixed << std::setprecision(1);
+        const FixedTimestep& timestep = fabric.getTimestep();
+        status << "Grid: " << grid.width << "x" << grid.height << " | Layers: " << fabric.getLayerCount()
+               << " | Step: " << fabric.getStepMilliseconds() << " ms on " << fabric.getThreadCount()
+               << " threads | Physics: " << static_cast<int>(timestep.getRate() + 0.5f) << " Hz";
+        if (fabric.isPhysicsThreaded()) {
+            status << " on its own thread, " << fabric.getPhysicsSteps() << " steps";
+        } else {
+            status << " x" << timestep.getLastSubsteps();
+        }
+        if (!fabric.isPhysicsThreaded() && timestep.getDroppedSteps() > 0) {
+            status << ", " << timestep.getDroppedSteps() << " dropped";
+        }
+        if (fabric.getSolverMode() == SOLVER_XPBD) {
+            status << " | Solver: XPBD x" << fabric.getSubsteps();
+        } else {
+            status << " | Solver: PBD x" << fabric.getIterations();
+        }
+        status << " | Residual: " << std::setprecision(4) << fabric.getResidual() << std::setprecision(1);
+        if (fabric.getTearRatio() > 0.0f) {
+            status << " | Torn: " << fabric.getTornCount();
+        }
+        if (fabric.isPlayingBack()) {
+            status << " | Playback: " << fabric.getPlaybackFrame() << "/" << fabric.getPlaybackFrameCount()
+                   << (paused ? " paused" : "");
+        } else if (fabric.isCaching()) {
+            status << " | Caching: " << fabric.getCachedFrames() << " steps";
+        }
+        if (replay.isLoaded()) {
+            status << " | Replay: " << replay.getPosition() << "/" << replay.getFrameCount();
+        } else if (fabric.isRecording()) {
+            status << " | Recording: " << fabric.getRecordedFrames() << " frames";
+        }
+        status << " | Vertices: " << fabric.getVertexCount() << " | Palette: " << paletteName;
+        return status.str();
+    }
+
+    sf::Vector2f getOverlayPosition() const override {
+        return sf::Vector2f(10.0f, grid.height * grid.cellSize + 10.0f);
+    }
+
+    // Everything on screen is the palette and its blends over black
+    std::vector<sf::Color> getRecordingColors() const override {
+        return palette;
+    }
+};
+
+#endif // FABRIC_SKETCH_HPP
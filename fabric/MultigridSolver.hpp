@@ -0,0 +1,311 @@
+#ifndef MULTIGRID_SOLVER_HPP
+#define MULTIGRID_SOLVER_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include "Verlet.hpp"
+#include "ConstraintSolver.hpp"
+#include "../lib/ThreadPool.hpp"
+
+// Coarse corrections for lattices of nodes joined to their right and lower
+// neighbours, run before the fine constraint solve. A Gauss-Seidel pass
+// only carries a correction a node or so, so on big lattices most of the
+// stretch a step adds is still there after a few passes.
+//
+// Level k keeps every 2^(k+1)-th row and column of the lattice (and always
+// the last ones), with constraints between neighbouring points as long as
+// the fine threads they span. Each step gathers the points' positions,
+// relaxes the coarsest level, interpolates its corrections onto the next
+// finer level and relaxes that, and so on down; the finest coarse level's
+// corrections are interpolated onto the nodes themselves.
+//
+// The pool holds count lattices one after another, each width x height in
+// row-major order; coarse constraints never join two of them. A torn fine
+// thread cuts the coarse constraints spanning it; see unlink().
+class MultigridSolver {
+public:
+    static constexpr int COARSE_ITERATIONS = 4;
+
+    // linked(index, horizontal) says whether the fine thread from a pool
+    // node to its right (or lower) neighbour is intact; coarse constraints
+    // only span intact threads. levels = 0 leaves the solver empty.
+    template <typename Linked>
+    void build(int width, int height, int count, float restLength, const NodeArrays& nodes, int levels,
+               Linked linked) {
+        m_width = width;
+        m_height = height;
+        m_count = count;
+        m_levels.clear();
+        m_levels.reserve(levels);
+
+        for (int k = 0; k < levels; ++k) {
+            const int stride = 2 << k;
+            // Nothing left to coarsen
+            if (!m_levels.empty() && m_levels.back().columns.size() <= 2 && m_levels.back().rows.size() <= 2) {
+                break;
+            }
+            m_levels.emplace_back();
+            Level& level = m_levels.back();
+            level.columns = points(width, stride);
+            level.rows = points(height, stride);
+            const std::vector<int> finerColumns = k == 0 ? points(width, 1) : m_levels[k - 1].columns;
+            const std::vector<int> finerRows = k == 0 ? points(height, 1) : m_levels[k - 1].rows;
+            interpolation(finerColumns, level.columns, level.columnCell, level.columnWeight);
+            interpolation(finerRows, level.rows, level.rowCell, level.rowWeight);
+
+            const int columnCount = static_cast<int>(level.columns.size());
+            const int rowCount = static_cast<int>(level.rows.size());
+            level.columnOf.assign(width, -1);
+            for (int c = 0; c < columnCount; ++c) {
+                level.columnOf[level.columns[c]] = c;
+            }
+            level.rowOf.assign(height, -1);
+            for (int r = 0; r < rowCount; ++r) {
+                level.rowOf[level.rows[r]] = r;
+            }
+            for (int lattice = 0; lattice < count; ++lattice) {
+                for (int r = 0; r < rowCount; ++r) {
+                    for (int c = 0; c < columnCount; ++c) {
+                        int index = fineIndex(lattice, level.columns[c], level.rows[r]);
+                        int point = level.nodes.add(nodes.position(index));
+                        level.nodes.setPinned(point, nodes.isPinned(index));
+                        level.fine.push_back(index);
+                    }
+                }
+            }
+            level.rightSlot.assign(level.nodes.size(), -1);
+            level.downSlot.assign(level.nodes.size(), -1);
+
+            for (int lattice = 0; lattice < count; ++lattice) {
+                const int first = lattice * columnCount * rowCount;
+                for (int r = 0; r < rowCount; ++r) {
+                    for (int c = 0; c < columnCount; ++c) {
+                        int point = first + r * columnCount + c;
+                        // Colors as in the fine grid: by direction and the
+                        // parity of the column or row
+                        if (c + 1 < columnCount &&
+                            spanLinked(lattice, level.columns[c], level.columns[c + 1], level.rows[r], true, linked)) {
+                            float length = (level.columns[c + 1] - level.columns[c]) * restLength;
+                            level.solver.add({point, point + 1, length}, c % 2);
+                            level.rightSlot[point] = static_cast<int>(level.solver.color(c % 2).size()) - 1;
+                        }
+                        if (r + 1 < rowCount &&
+                            spanLinked(lattice, level.rows[r], level.rows[r + 1], level.columns[c], false, linked)) {
+                            float length = (level.rows[r + 1] - level.rows[r]) * restLength;
+                            level.solver.add({point, point + columnCount, length}, 2 + r % 2);
+                            level.downSlot[point] = static_cast<int>(level.solver.color(2 + r % 2).size()) - 1;
+                        }
+                    }
+                }
+            }
+            level.baseX.resize(level.nodes.size());
+            level.baseY.resize(level.nodes.size());
+        }
+    }
+
+    // Removes the coarse constraints that span the fine thread from a pool
+    // node to its right (or lower) neighbour
+    void unlink(int index, bool horizontal) {
+        const int lattice = index / (m_width * m_height);
+        const int x = index % m_width;
+        const int y = index / m_width % m_height;
+        for (auto& level : m_levels) {
+            const int columnCount = static_cast<int>(level.columns.size());
+            const int first = lattice * columnCount * static_cast<int>(level.rows.size());
+            if (horizontal && level.rowOf[y] >= 0) {
+                int c = static_cast<int>(std::upper_bound(level.columns.begin(), level.columns.end(), x) -
+                                         level.columns.begin()) - 1;
+                cut(level, first + level.rowOf[y] * columnCount + c, true, c % 2);
+            } else if (!horizontal && level.columnOf[x] >= 0) {
+                int r = static_cast<int>(std::upper_bound(level.rows.begin(), level.rows.end(), y) -
+                                         level.rows.begin()) - 1;
+                cut(level, first + r * columnCount + level.columnOf[x], false, 2 + r % 2);
+            }
+        }
+    }
+
+    int getLevelCount() const {
+        return static_cast<int>(m_levels.size());
+    }
+
+    // Coarse points over all levels, for comparison with the node count
+    size_t getPointCount() const {
+        size_t count = 0;
+        for (const auto& level : m_levels) {
+            count += level.nodes.size();
+        }
+        return count;
+    }
+
+    // Moves the nodes by the coarse levels' corrections
+    void solve(NodeArrays& nodes, ThreadPool* pool) {
+        if (m_levels.empty()) {
+            return;
+        }
+        for (auto& level : m_levels) {
+            for (size_t i = 0; i < level.fine.size(); ++i) {
+                level.baseX[i] = level.nodes.x[i] = nodes.x[level.fine[i]];
+                level.baseY[i] = level.nodes.y[i] = nodes.y[level.fine[i]];
+            }
+        }
+
+        for (int k = getLevelCount() - 1; k >= 0; --k) {
+            Level& level = m_levels[k];
+            if (k + 1 < getLevelCount()) {
+                prolong(m_levels[k + 1], static_cast<int>(level.columns.size()), static_cast<int>(level.rows.size()),
+                        level.nodes, nullptr);
+            }
+            level.solver.solve(level.nodes, COARSE_ITERATIONS, pool);
+        }
+        prolong(m_levels[0], m_width, m_height, nodes, pool);
+    }
+
+private:
+    struct Level {
+        // Lattice columns and rows of the points
+        std::vector<int> columns;
+        std::vector<int> rows;
+        // For each column (row) of the next finer level, the point column
+        // (row) at or left of it, below the last, and how far it is on
+        // towards the next one
+        std::vector<int> columnCell;
+        std::vector<float> columnWeight;
+        std::vector<int> rowCell;
+        std::vector<float> rowWeight;
+        // Point column (row) of each lattice column (row), or -1
+        std::vector<int> columnOf;
+        std::vector<int> rowOf;
+        // Where each point's constraint to its right (lower) neighbour is
+        // in its color, or -1
+        std::vector<int> rightSlot;
+        std::vector<int> downSlot;
+        // The points, lattice after lattice, and the pool node of each
+        NodeArrays nodes;
+        std::vector<int> fine;
+        // Positions as gathered, before this step's corrections
+        std::vector<float> baseX;
+        std::vector<float> baseY;
+        ConstraintSolver solver;
+    };
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_count = 0;
+    std::vector<Level> m_levels;
+
+    void cut(Level& level, int point, bool horizontal, int color) {
+        int& slot = horizontal ? level.rightSlot[point] : level.downSlot[point];
+        if (slot < 0) {
+            return;
+        }
+        const size_t index = static_cast<size_t>(slot);
+        const Constraint moved = level.solver.color(color).back();
+        level.solver.remove(color, index);
+        slot = -1;
+        // The color's last constraint now sits where the cut one was
+        if (index < level.solver.color(color).size()) {
+            int a = moved.nodeAIndex;
+            (moved.nodeBIndex == a + 1 ? level.rightSlot[a] : level.downSlot[a]) = static_cast<int>(index);
+        }
+    }
+
+    int fineIndex(int lattice, int column, int row) const {
+        return (lattice * m_height + row) * m_width + column;
+    }
+
+    // 0, stride, 2 * stride, ... and the last index
+    static std::vector<int> points(int size, int stride) {
+        std::vector<int> result;
+        for (int i = 0; i < size; i += stride) {
+            result.push_back(i);
+        }
+        if (result.back() != size - 1) {
+            result.push_back(size - 1);
+        }
+        return result;
+    }
+
+    static void interpolation(const std::vector<int>& finer, const std::vector<int>& coarse, std::vector<int>& cell,
+                              std::vector<float>& weight) {
+        cell.resize(finer.size());
+        weight.resize(finer.size());
+        size_t c = 0;
+        for (size_t i = 0; i < finer.size(); ++i) {
+            while (c + 2 < coarse.size() && coarse[c + 1] <= finer[i]) {
+                ++c;
+            }
+            cell[i] = static_cast<int>(c);
+            weight[i] = static_cast<float>(finer[i] - coarse[c]) / (coarse[c + 1] - coarse[c]);
+        }
+    }
+
+    // Whether every fine thread from from to to (along a row when
+    // horizontal, else down a column) at the given cross position is intact
+    template <typename Linked>
+    bool spanLinked(int lattice, int from, int to, int across, bool horizontal, Linked& linked) const {
+        for (int i = from; i < to; ++i) {
+            int index = horizontal ? fineIndex(lattice, i, across) : fineIndex(lattice, across, i);
+            if (!linked(index, horizontal)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Adds the coarse level's corrections, bilinearly interpolated, to the
+    // free points of the next finer lattice (columns x rows per lattice)
+    void prolong(const Level& coarse, int columns, int rows, NodeArrays& target, ThreadPool* pool) const {
+        const int coarseColumns = static_cast<int>(coarse.columns.size());
+        const int coarseRows = static_cast<int>(coarse.rows.size());
+        const size_t totalRows = static_cast<size_t>(m_count) * rows;
+
+        auto prolongRows = [&](size_t begin, size_t end) {
+            for (size_t fineRow = begin; fineRow < end; ++fineRow) {
+                const int lattice = static_cast<int>(fineRow / rows);
+                const int r = static_cast<int>(fineRow % rows);
+                const int top = (lattice * coarseRows + coarse.rowCell[r]) * coarseColumns;
+                const int bottom = top + coarseColumns;
+                const float v = coarse.rowWeight[r];
+                float* x = target.x.data() + fineRow * columns;
+                float* y = target.y.data() + fineRow * columns;
+                const uint32_t* free = target.freeMask.data() + fineRow * columns;
+                for (int c = 0; c < columns; ++c) {
+                    if (!free[c]) {
+                        continue;
+                    }
+                    const int left = coarse.columnCell[c];
+                    const float u = coarse.columnWeight[c];
+                    x[c] += lerp(lerp(deltaX(coarse, top + left), deltaX(coarse, top + left + 1), u),
+                                 lerp(deltaX(coarse, bottom + left), deltaX(coarse, bottom + left + 1), u), v);
+                    y[c] += lerp(lerp(deltaY(coarse, top + left), deltaY(coarse, top + left + 1), u),
+                                 lerp(deltaY(coarse, bottom + left), deltaY(coarse, bottom + left + 1), u), v);
+                }
+            }
+        };
+
+        if (pool && pool->size() > 1 && totalRows * columns >= ConstraintSolver::PARALLEL_THRESHOLD) {
+            pool->run([&](int worker, int workers) {
+                auto range = ThreadPool::split(totalRows, worker, workers);
+                prolongRows(range.first, range.second);
+            });
+        } else {
+            prolongRows(0, totalRows);
+        }
+    }
+
+    static float deltaX(const Level& level, int point) {
+        return level.nodes.x[point] - level.baseX[point];
+    }
+
+    static float deltaY(const Level& level, int point) {
+        return level.nodes.y[point] - level.baseY[point];
+    }
+
+    static float lerp(float a, float b, float t) {
+        return a + (b - a) * t;
+    }
+};
+
+#endif // MULTIGRID_SOLVER_HPP
@@ -0,0 +1,353 @@
+#ifndef VERLET_HPP
+#define VERLET_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Fabric nodes as a structure of arrays, so the per-node passes stream
+// through memory and vectorize. A node is free when its mask is all ones
+// and pinned when it is zero; the kernels blend with the mask instead of
+// branching, so pinned nodes never move.
+struct NodeArrays {
+    static constexpr uint32_t FREE = 0xFFFFFFFFu;
+    static constexpr uint32_t PINNED = 0u;
+
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> prevX;
+    std::vector<float> prevY;
+    std::vector<uint32_t> freeMask;
+
+    size_t size() const {
+        return x.size();
+    }
+
+    void clear() {
+        x.clear();
+        y.clear();
+        prevX.clear();
+        prevY.clear();
+        freeMask.clear();
+    }
+
+    // Appends a free node at rest; returns its index
+    int add(sf::Vector2f position) {
+        x.push_back(position.x);
+        y.push_back(position.y);
+        prevX.push_back(position.x);
+        prevY.push_back(position.y);
+        freeMask.push_back(FREE);
+        return static_cast<int>(x.size()) - 1;
+    }
+
+    sf::Vector2f position(int i) const {
+        return sf::Vector2f(x[i], y[i]);
+    }
+
+    // Moves the node and stops it
+    void place(int i, sf::Vector2f position) {
+        x[i] = prevX[i] = position.x;
+        y[i] = prevY[i] = position.y;
+    }
+
+    bool isPinned(int i) const {
+        return freeMask[i] == PINNED;
+    }
+
+    void setPinned(int i, bool pinned) {
+        freeMask[i] = pinned ? PINNED : FREE;
+    }
+};
+
+// Per-node passes of the fabric step. Built for AVX2 (8 nodes at a time)
+// when the compiler targets it (-mavx2, see ENABLE_AVX2 in CMakeLists.txt),
+// otherwise SSE2 (4 at a time), with a scalar loop for the remainder.
+namespace verlet {
+
+    struct MouseForce {
+        float x, y;
+        float radius;
+        // Strength, force multiplier and timestep combined
+        float impulse;
+    };
+
+    // Bounding box of some nodes. NaN positions are left out.
+    struct Bounds {
+        float minX = INFINITY;
+        float minY = INFINITY;
+        float maxX = -INFINITY;
+        float maxY = -INFINITY;
+
+        void add(float x, float y) {
+            minX = x < minX ? x : minX;
+            minY = y < minY ? y : minY;
+            maxX = x > maxX ? x : maxX;
+            maxY = y > maxY ? y : maxY;
+        }
+
+        void add(const Bounds& other) {
+            minX = std::min(minX, other.minX);
+            minY = std::min(minY, other.minY);
+            maxX = std::max(maxX, other.maxX);
+            maxY = std::max(maxY, other.maxY);
+        }
+
+        // Whether the box comes within distance of the point
+        bool near(float x, float y, float distance) const {
+            float dx = std::max(std::max(minX - x, x - maxX), 0.0f);
+            float dy = std::max(std::max(minY - y, y - maxY), 0.0f);
+            return dx * dx + dy * dy <= distance * distance;
+        }
+    };
+
+    inline const char* kernelName() {
+#if defined(__AVX2__)
+        return "AVX2";
+#elif defined(__SSE2__)
+        return "SSE2";
+#else
+        return "scalar";
+#endif
+    }
+
+    // Pushes free nodes within the radius away from the mouse, falling off
+    // as 1 / (distance + 1)
+    inline void applyMouseForceScalar(NodeArrays& nodes, size_t begin, size_t end, const MouseForce& mouse) {
+        for (size_t i = begin; i < end; ++i) {
+            float dx = nodes.x[i] - mouse.x;
+            float dy = nodes.y[i] - mouse.y;
+            float distance = std::sqrt(dx * dx + dy * dy);
+            if (nodes.freeMask[i] && distance < mouse.radius) {
+                float scale = mouse.impulse / (distance + 1.0f);
+                nodes.x[i] += dx * scale;
+                nodes.y[i] += dy * scale;
+            }
+        }
+    }
+
+    // Verlet step: carry the velocity (x - prevX) with damping, add gravity.
+    // Returns the bounds of the new positions, which come almost for free
+    // while the nodes are loaded anyway.
+    inline Bounds integrateScalar(NodeArrays& nodes, size_t begin, size_t end, float damping, float gravityStep) {
+        Bounds bounds;
+        for (size_t i = begin; i < end; ++i) {
+            if (nodes.freeMask[i]) {
+                float x = nodes.x[i];
+                float y = nodes.y[i];
+                nodes.x[i] = x + (x - nodes.prevX[i]) * damping;
+                nodes.y[i] = y + (y - nodes.prevY[i]) * damping + gravityStep;
+                nodes.prevX[i] = x;
+                nodes.prevY[i] = y;
+            }
+            bounds.add(nodes.x[i], nodes.y[i]);
+        }
+        return bounds;
+    }
+
+#if defined(__AVX2__)
+
+    constexpr size_t WIDTH = 8;
+
+    inline void applyMouseForce(NodeArrays& nodes, size_t begin, size_t end, const MouseForce& mouse) {
+        const __m256 mouseX = _mm256_set1_ps(mouse.x);
+        const __m256 mouseY = _mm256_set1_ps(mouse.y);
+        const __m256 radius = _mm256_set1_ps(mouse.radius);
+        const __m256 radiusSquared = _mm256_set1_ps(mouse.radius * mouse.radius * 1.0001f);
+        const __m256 impulse = _mm256_set1_ps(mouse.impulse);
+        const __m256 one = _mm256_set1_ps(1.0f);
+
+        size_t i = begin;
+        for (; i + WIDTH <= end; i += WIDTH) {
+            __m256 x = _mm256_loadu_ps(&nodes.x[i]);
+            __m256 y = _mm256_loadu_ps(&nodes.y[i]);
+            __m256 dx = _mm256_sub_ps(x, mouseX);
+            __m256 dy = _mm256_sub_ps(y, mouseY);
+            __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+
+            // Most of the cloth is out of reach: skip the square root
+            if (_mm256_movemask_ps(_mm256_cmp_ps(d2, radiusSquared, _CMP_LT_OQ)) == 0) {
+                continue;
+            }
+
+            __m256 distance = _mm256_sqrt_ps(d2);
+            __m256 mask = _mm256_and_ps(_mm256_cmp_ps(distance, radius, _CMP_LT_OQ),
+                                        _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&nodes.freeMask[i]))));
+            __m256 scale = _mm256_and_ps(_mm256_div_ps(impulse, _mm256_add_ps(distance, one)), mask);
+            _mm256_storeu_ps(&nodes.x[i], _mm256_add_ps(x, _mm256_mul_ps(dx, scale)));
+            _mm256_storeu_ps(&nodes.y[i], _mm256_add_ps(y, _mm256_mul_ps(dy, scale)));
+        }
+        applyMouseForceScalar(nodes, i, end, mouse);
+    }
+
+    inline float horizontalMin(__m256 v) {
+        __m128 m = _mm_min_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+        return _mm_cvtss_f32(_mm_min_ss(m, _mm_shuffle_ps(m, m, 1)));
+    }
+
+    inline float horizontalMax(__m256 v) {
+        __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+        return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, 1)));
+    }
+
+    inline Bounds integrate(NodeArrays& nodes, size_t begin, size_t end, float damping, float gravityStep) {
+        const __m256 damp = _mm256_set1_ps(damping);
+        const __m256 gravity = _mm256_set1_ps(gravityStep);
+        // min/max return the second operand for NaN, so NaN never sticks
+        __m256 minX = _mm256_set1_ps(INFINITY);
+        __m256 minY = minX;
+        __m256 maxX = _mm256_set1_ps(-INFINITY);
+        __m256 maxY = maxX;
+
+        size_t i = begin;
+        for (; i + WIDTH <= end; i += WIDTH) {
+            __m256 free = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&nodes.freeMask[i])));
+            __m256 x = _mm256_loadu_ps(&nodes.x[i]);
+            __m256 y = _mm256_loadu_ps(&nodes.y[i]);
+            __m256 prevX = _mm256_loadu_ps(&nodes.prevX[i]);
+            __m256 prevY = _mm256_loadu_ps(&nodes.prevY[i]);
+
+            __m256 nextX = _mm256_add_ps(x, _mm256_mul_ps(_mm256_sub_ps(x, prevX), damp));
+            __m256 nextY = _mm256_add_ps(_mm256_add_ps(y, _mm256_mul_ps(_mm256_sub_ps(y, prevY), damp)), gravity);
+
+            nextX = _mm256_blendv_ps(x, nextX, free);
+            nextY = _mm256_blendv_ps(y, nextY, free);
+            _mm256_storeu_ps(&nodes.x[i], nextX);
+            _mm256_storeu_ps(&nodes.y[i], nextY);
+            _mm256_storeu_ps(&nodes.prevX[i], _mm256_blendv_ps(prevX, x, free));
+            _mm256_storeu_ps(&nodes.prevY[i], _mm256_blendv_ps(prevY, y, free));
+
+            minX = _mm256_min_ps(nextX, minX);
+            minY = _mm256_min_ps(nextY, minY);
+            maxX = _mm256_max_ps(nextX, maxX);
+            maxY = _mm256_max_ps(nextY, maxY);
+        }
+        Bounds bounds = integrateScalar(nodes, i, end, damping, gravityStep);
+        Bounds vector;
+        vector.minX = horizontalMin(minX);
+        vector.minY = horizontalMin(minY);
+        vector.maxX = horizontalMax(maxX);
+        vector.maxY = horizontalMax(maxY);
+        bounds.add(vector);
+        return bounds;
+    }
+
+#elif defined(__SSE2__)
+
+    constexpr size_t WIDTH = 4;
+
+    // (a & mask) | (b & ~mask)
+    inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    inline void applyMouseForce(NodeArrays& nodes, size_t begin, size_t end, const MouseForce& mouse) {
+        const __m128 mouseX = _mm_set1_ps(mouse.x);
+        const __m128 mouseY = _mm_set1_ps(mouse.y);
+        const __m128 radius = _mm_set1_ps(mouse.radius);
+        const __m128 radiusSquared = _mm_set1_ps(mouse.radius * mouse.radius * 1.0001f);
+        const __m128 impulse = _mm_set1_ps(mouse.impulse);
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        size_t i = begin;
+        for (; i + WIDTH <= end; i += WIDTH) {
+            __m128 x = _mm_loadu_ps(&nodes.x[i]);
+            __m128 y = _mm_loadu_ps(&nodes.y[i]);
+            __m128 dx = _mm_sub_ps(x, mouseX);
+            __m128 dy = _mm_sub_ps(y, mouseY);
+            __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+            // Most of the cloth is out of reach: skip the square root
+            if (_mm_movemask_ps(_mm_cmplt_ps(d2, radiusSquared)) == 0) {
+                continue;
+            }
+
+            __m128 distance = _mm_sqrt_ps(d2);
+            __m128 mask = _mm_and_ps(_mm_cmplt_ps(distance, radius),
+                                     _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&nodes.freeMask[i]))));
+            __m128 scale = _mm_and_ps(_mm_div_ps(impulse, _mm_add_ps(distance, one)), mask);
+            _mm_storeu_ps(&nodes.x[i], _mm_add_ps(x, _mm_mul_ps(dx, scale)));
+            _mm_storeu_ps(&nodes.y[i], _mm_add_ps(y, _mm_mul_ps(dy, scale)));
+        }
+        applyMouseForceScalar(nodes, i, end, mouse);
+    }
+
+    inline float horizontalMin(__m128 m) {
+        m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+        return _mm_cvtss_f32(_mm_min_ss(m, _mm_shuffle_ps(m, m, 1)));
+    }
+
+    inline float horizontalMax(__m128 m) {
+        m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+        return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, 1)));
+    }
+
+    inline Bounds integrate(NodeArrays& nodes, size_t begin, size_t end, float damping, float gravityStep) {
+        const __m128 damp = _mm_set1_ps(damping);
+        const __m128 gravity = _mm_set1_ps(gravityStep);
+        // min/max return the second operand for NaN, so NaN never sticks
+        __m128 minX = _mm_set1_ps(INFINITY);
+        __m128 minY = minX;
+        __m128 maxX = _mm_set1_ps(-INFINITY);
+        __m128 maxY = maxX;
+
+        size_t i = begin;
+        for (; i + WIDTH <= end; i += WIDTH) {
+            __m128 free = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&nodes.freeMask[i])));
+            __m128 x = _mm_loadu_ps(&nodes.x[i]);
+            __m128 y = _mm_loadu_ps(&nodes.y[i]);
+            __m128 prevX = _mm_loadu_ps(&nodes.prevX[i]);
+            __m128 prevY = _mm_loadu_ps(&nodes.prevY[i]);
+
+            __m128 nextX = _mm_add_ps(x, _mm_mul_ps(_mm_sub_ps(x, prevX), damp));
+            __m128 nextY = _mm_add_ps(_mm_add_ps(y, _mm_mul_ps(_mm_sub_ps(y, prevY), damp)), gravity);
+
+            nextX = select(free, nextX, x);
+            nextY = select(free, nextY, y);
+            _mm_storeu_ps(&nodes.x[i], nextX);
+            _mm_storeu_ps(&nodes.y[i], nextY);
+            _mm_storeu_ps(&nodes.prevX[i], select(free, x, prevX));
+            _mm_storeu_ps(&nodes.prevY[i], select(free, y, prevY));
+
+            minX = _mm_min_ps(nextX, minX);
+            minY = _mm_min_ps(nextY, minY);
+            maxX = _mm_max_ps(nextX, maxX);
+            maxY = _mm_max_ps(nextY, maxY);
+        }
+        Bounds bounds = integrateScalar(nodes, i, end, damping, gravityStep);
+        Bounds vector;
+        vector.minX = horizontalMin(minX);
+        vector.minY = horizontalMin(minY);
+        vector.maxX = horizontalMax(maxX);
+        vector.maxY = horizontalMax(maxY);
+        bounds.add(vector);
+        return bounds;
+    }
+
+#else
+
+    constexpr size_t WIDTH = 1;
+
+    inline void applyMouseForce(NodeArrays& nodes, size_t begin, size_t end, const MouseForce& mouse) {
+        applyMouseForceScalar(nodes, begin, end, mouse);
+    }
+
+    inline Bounds integrate(NodeArrays& nodes, size_t begin, size_t end, float damping, float gravityStep) {
+        return integrateScalar(nodes, begin, end, damping, gravityStep);
+    }
+
+#endif
+}
+
+#endif // VERLET_HPP
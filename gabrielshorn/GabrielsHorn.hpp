@@ -0,0 +1,144 @@
+#ifndef GABRIELS_HORN_HPP
+#define GABRIELS_HORN_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <string>
+#include <cmath>
+#include "../lib/Palettes.hpp"
+#include "../lib/GradientSampler.hpp"
+
+const int WINDOW_WIDTH = 800;
+const int WINDOW_HEIGHT = 600;
+const float HORN_LENGTH = 10.0f;
+const int SEGMENTS = 200;
+const int CIRCLE_POINTS = 30;
+const float SCALE = 50.0f;
+const float ROTATION_SPEED = 0.3f;
+
+class GabrielsHorn {
+private:
+    std::vector<sf::VertexArray> hornSegments;
+    float rotationAngleY;
+    float rotationAngleX;
+    // Colors around each ring and along the length, sampled once
+    std::vector<sf::Color> ringColors;
+    std::vector<sf::Color> lengthColors;
+    float currentHornLength;
+
+public:
+    GabrielsHorn(const std::string& paletteName) 
+        : rotationAngleY(0.0f), rotationAngleX(0.0f), currentHornLength(HORN_LENGTH) {
+        const std::vector<sf::Color>& palette = getPalette(paletteName);
+
+        // Once around each ring (wrapping back to the first color), and
+        // from the first color to the last down the horn
+        std::vector<float> positions(CIRCLE_POINTS + 1);
+        for (int j = 0; j <= CIRCLE_POINTS; ++j) {
+            positions[j] = static_cast<float>(j) / CIRCLE_POINTS;
+        }
+        ringColors.resize(positions.size());
+        GradientSampler(palette, true).sample(positions.data(), positions.size(), ringColors.data());
+
+        positions.resize(SEGMENTS);
+        for (int i = 0; i < SEGMENTS; ++i) {
+            positions[i] = static_cast<float>(i) / (SEGMENTS - 1);
+        }
+        lengthColors.resize(positions.size());
+        GradientSampler(palette).sample(positions.data(), positions.size(), lengthColors.data());
+
+        generateHorn();
+    }
+    
+    void regenerateHorn() {
+        generateHorn();
+    }
+
+    void setHornLengthFromMouse(int mouseY) {
+        currentHornLength = 2.0f + (static_cast<float>(mouseY) / WINDOW_HEIGHT) * 18.0f;
+        generateHorn();
+    }
+
+    void setRotationFromMouseY(int mouseX) {
+        rotationAngleY = (static_cast<float>(mouseX) / WINDOW_WIDTH) * 2.0f * M_PI;
+    }
+
+    // Spins the horn about its axis; used when there is no mouse to follow
+    void rotate(float deltaTime) {
+        rotationAngleY = std::fmod(rotationAngleY + ROTATION_SPEED * deltaTime, 2.0f * static_cast<float>(M_PI));
+        generateHorn();
+    }
+
+    void setRotationFromMouseX(int mouseX) {
+        // Map mouseX from 0 to WINDOW_WIDTH to an angle from -PI to PI
+        rotationAngleX = (static_cast<float>(mouseX) / WINDOW_WIDTH) * 2.0f * M_PI - M_PI;
+    }
+
+    void generateHorn() {
+        hornSegments.clear();
+
+        for (int i = 0; i < SEGMENTS; ++i) {
+            float y = 1.0f + (currentHornLength * i) / SEGMENTS;
+            float radius = 1.0f / y;
+
+            sf::VertexArray circle(sf::LineStrip);
+
+            for (int j = 0; j <= CIRCLE_POINTS; ++j) {
+                float angle = 2.0f * M_PI * j / CIRCLE_POINTS;
+                float x = radius * std::cos(angle);
+                float z = radius * std::sin(angle);
+
+                sf::Vector2f projected = isometricProjection(x, -y, z);
+
+                sf::Color color = ringColors[j];
+                circle.append(sf::Vertex(projected, color));
+            }
+
+            hornSegments.push_back(circle);
+        }
+
+        for (int j = 0; j < CIRCLE_POINTS; ++j) {
+            sf::VertexArray line(sf::LineStrip);
+
+            for (int i = 0; i < SEGMENTS; ++i) {
+                float y = 1.0f + (currentHornLength * i) / SEGMENTS;
+                float radius = 1.0f / y;
+                float angle = 2.0f * M_PI * j / CIRCLE_POINTS;
+                float x = radius * std::cos(angle);
+                float z = radius * std::sin(angle);
+
+                sf::Vector2f projected = isometricProjection(x, -y, z);
+
+                sf::Color color = lengthColors[i];
+                line.append(sf::Vertex(projected, color));
+            }
+
+            hornSegments.push_back(line);
+        }
+    }
+
+    sf::Vector2f isometricProjection(float x, float y, float z) {
+        // Rotation around the X-axis
+        float tempY = y * std::cos(rotationAngleX) - z * std::sin(rotationAngleX);
+        float tempZ = y * std::sin(rotationAngleX) + z * std::cos(rotationAngleX);
+        y = tempY;
+        z = tempZ;
+
+        // Rotation around the Y-axis
+        float tempX = x * std::cos(rotationAngleY) - z * std::sin(rotationAngleY);
+        float rotatedZ = x * std::sin(rotationAngleY) + z * std::cos(rotationAngleY);
+        float rotatedX = tempX;
+
+        float screenX = WINDOW_WIDTH / 2.0f + SCALE * (rotatedX - rotatedZ);
+        float screenY = WINDOW_HEIGHT / 2.0f - SCALE * (y + (rotatedX + rotatedZ) * 0.3f);
+        return sf::Vector2f(screenX, screenY);
+    }
+
+    void drawHorn(sf::RenderTarget& target) const {
+        for (const auto& segment : hornSegments) {
+            target.draw(segment);
+        }
+    }
+};
+
+#endif // GABRIELS_HORN_HPP
@@ -0,0 +1,62 @@
+#ifndef GABRIELS_HORN_SKETCH_HPP
+#define GABRIELS_HORN_SKETCH_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <iostream>
+#include "GabrielsHorn.hpp"
+#include "../lib/Sketch.hpp"
+
+// The mouse sets the horn's length and rotation (dragging tilts it);
+// without one (headless renders) it turns at ROTATION_SPEED.
+class GabrielsHornSketch : public Sketch {
+private:
+    std::string paletteName;
+    GabrielsHorn horn;
+
+public:
+    static constexpr const char* NAME = "gabrielshorn";
+    static constexpr const char* DESCRIPTION = "Gabriel's Horn in isometric projection";
+
+    explicit GabrielsHornSketch(SketchResources& resources)
+        : paletteName(resources.getPaletteName()), horn(paletteName) {}
+
+    sf::Vector2u getSize() const override {
+        return sf::Vector2u(WINDOW_WIDTH, WINDOW_HEIGHT);
+    }
+
+    void reset() override {
+        horn.regenerateHorn();
+        std::cout << "Horn regenerated." << std::endl;
+    }
+
+    bool handleEvent(const sf::Event& event) override {
+        if (event.type != sf::Event::MouseMoved) {
+            return false;
+        }
+        horn.setHornLengthFromMouse(event.mouseMove.y);
+        if (sf::Mouse::isButtonPressed(sf::Mouse::Left)) {
+            horn.setRotationFromMouseX(event.mouseMove.x);
+        } else {
+            horn.setRotationFromMouseY(event.mouseMove.x);
+        }
+        return true;
+    }
+
+    void update(float deltaTime, const SketchInput& input) override {
+        if (!input.hasMouse) {
+            horn.rotate(deltaTime);
+        }
+    }
+
+    void draw(sf::RenderTarget& target) override {
+        target.clear(sf::Color::Black);
+        horn.drawHorn(target);
+    }
+
+    std::string getStatus() const override {
+        return "Palette: " + paletteName;
+    }
+};
+
+#endif // GABRIELS_HORN_SKETCH_HPP
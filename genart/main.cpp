@@ -0,0 +1,53 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include "../lib/SketchHost.hpp"
+#include "../fabric/FabricSketch.hpp"
+#include "../gabrielshorn/GabrielsHornSketch.hpp"
+#include "../audiovisualizer/AudioVisualizerSketch.hpp"
+#include "../monograph/MonographSketch.hpp"
+#include "../gridgen/GridGenSketch.hpp"
+#include "../particlesystem/ParticleSketch.hpp"
+#include "../smithtiles/SmithTilesSketch.hpp"
+
+// Every sketch in one program. Tab (Shift+Tab) or the number keys switch
+// between them without reopening the window.
+//
+//   ./genart [--sketch NAME] [--list] [headless options]
+//
+// --headless renders the sketch given with --sketch.
+int main(int argc, char* argv[]) {
+    SketchRegistry registry;
+    registry.add<AudioVisualizerSketch>();
+    registry.add<MonographSketch>();
+    registry.add<GridGenSketch>();
+    registry.add(ParticleSketch::NAME, ParticleSketch::DESCRIPTION, ParticleSketch::create);
+    registry.add<FabricSketch>();
+    registry.add<GabrielsHornSketch>();
+    registry.add<SmithTilesSketch>();
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--list") == 0) {
+            for (size_t j = 0; j < registry.size(); ++j) {
+                std::cout << j + 1 << ". " << registry.at(j).name << ": " << registry.at(j).description << std::endl;
+            }
+            return 0;
+        }
+    }
+
+    SketchResources resources(argc, argv);
+    std::string name = resources.argument("--sketch");
+    if (name.empty() && resources.isHeadless()) {
+        std::cerr << "--headless needs --sketch NAME (see --list)." << std::endl;
+        return 1;
+    }
+
+    int index = name.empty() ? 0 : registry.find(name);
+    if (index < 0) {
+        std::cerr << "Unknown sketch '" << name << "' (see --list)." << std::endl;
+        return 1;
+    }
+
+    SketchHost host(registry, resources);
+    return host.run(index);
+}
@@ -7,16 +7,24 @@
 #include <random>
 #include <algorithm>
 #include "../lib/Palettes.hpp"
+#include "../lib/GradientSampler.hpp"
 
 class GridGen {
 private:
-    sf::RenderWindow& window;
+    int width;
+    int height;
     std::vector<std::vector<sf::Vector2f>> points;
     std::vector<std::vector<sf::Vector2f>> originalPoints;
     int cols;
     int rows;
     float pointRadius;
     std::vector<sf::Color> palette;
+    GradientSampler gradient;
+
+    // Gradient positions and colors, recomputed only when the points move:
+    // one per point, then one per horizontal and one per vertical line
+    std::vector<float> colorPositions;
+    std::vector<sf::Color> colors;
 
     // Circle
     struct AttractorCircle {
@@ -31,13 +39,11 @@ private:
     std::uniform_real_distribution<> dis;
 
 public:
-    GridGen(sf::RenderWindow& win, int c, int r, const std::string& paletteName) 
-        : window(win), cols(c), rows(r), dis(0.0, 1.0) {
+    GridGen(int w, int h, int c, int r, const std::string& paletteName, unsigned int seed = std::random_device{}())
+        : width(w), height(h), cols(c), rows(r), gen(seed), dis(0.0, 1.0) {
         pointRadius = 4.0f;
         palette = getPalette(paletteName);
-
-        std::random_device rd;
-        gen.seed(rd());
+        gradient.setColors(palette);
 
         generateGrid();
         generateCircles();
@@ -50,10 +56,10 @@ public:
         points.resize(rows, std::vector<sf::Vector2f>(cols));
         originalPoints.resize(rows, std::vector<sf::Vector2f>(cols));
 
-        float marginX = window.getSize().x * 0.15f;
-        float marginY = window.getSize().y * 0.15f;
-        float drawableWidth = window.getSize().x - 2 * marginX;
-        float drawableHeight = window.getSize().y - 2 * marginY;
+        float marginX = width * 0.15f;
+        float marginY = height * 0.15f;
+        float drawableWidth = width - 2 * marginX;
+        float drawableHeight = height - 2 * marginY;
 
         for (int i = 0; i < rows; ++i) {
             for (int j = 0; j < cols; ++j) {
@@ -76,8 +82,8 @@ public:
 
             // Random position within central area
             float margin = 0.3f;
-            circle.center.x = window.getSize().x * (margin + dis(gen) * (1 - 2*margin));
-            circle.center.y = window.getSize().y * (margin + dis(gen) * (1 - 2*margin));
+            circle.center.x = width * (margin + dis(gen) * (1 - 2*margin));
+            circle.center.y = height * (margin + dis(gen) * (1 - 2*margin));
 
             // Random radius and strength
             circle.radius = 30.0f + dis(gen) * 70.0f;
@@ -120,6 +126,29 @@ public:
                 points[i][j] = applyDistortionToPoint(originalPoints[i][j]);
             }
         }
+        updateColors();
+    }
+
+    // Lines take the color at their midpoint
+    void updateColors() {
+        colorPositions.clear();
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                colorPositions.push_back(getColorPosition(points[i][j]));
+            }
+        }
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j + 1 < cols; ++j) {
+                colorPositions.push_back(getColorPosition((points[i][j] + points[i][j + 1]) / 2.0f));
+            }
+        }
+        for (int i = 0; i + 1 < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                colorPositions.push_back(getColorPosition((points[i][j] + points[i + 1][j]) / 2.0f));
+            }
+        }
+        colors.resize(colorPositions.size());
+        gradient.sample(colorPositions.data(), colorPositions.size(), colors.data());
     }
 
     float getCircleSizeForPoint(const sf::Vector2f& point) {
@@ -140,9 +169,8 @@ public:
         return pointRadius * (1.0f + maxSizeFactor);
     }
 
-    sf::Color getColorForPoint(const sf::Vector2f& point) {
-        if (palette.empty()) return sf::Color::White;
-
+    // 1 at the nearest attractor's center, falling to 0 at 1.5 radii
+    float getColorPosition(const sf::Vector2f& point) {
         float minDist = std::numeric_limits<float>::max();
         float nearestRadius = 1.0f;
 
@@ -159,11 +187,11 @@ public:
         }
 
         float normalizedDist = std::min(1.0f, minDist / (nearestRadius * 1.5f));
-        int colorIndex = static_cast<int>((1.0f - normalizedDist) * (palette.size() - 1));
-        colorIndex = std::min(static_cast<int>(palette.size() - 1), 
-                             std::max(0, colorIndex));
+        return 1.0f - normalizedDist;
+    }
 
-        return palette[colorIndex];
+    sf::Color getColorForPoint(const sf::Vector2f& point) {
+        return gradient.sample(getColorPosition(point));
     }
 
     sf::Color getLineColor(const sf::Vector2f& start, const sf::Vector2f& end) {
@@ -178,28 +206,34 @@ public:
         return getColorForPoint(midpoint);
     }
 
-    void draw() {
-        window.clear(sf::Color::Black);
+    void draw(sf::RenderTarget& target) {
+        target.clear(sf::Color::Black);
+
+        const sf::Color* pointColors = colors.data();
+        const sf::Color* horizontalColors = pointColors + rows * cols;
+        const sf::Color* verticalColors = horizontalColors + rows * (cols - 1);
 
         // Draw grid lines with color gradient
         for (int i = 0; i < rows; ++i) {
             for (int j = 0; j < cols; ++j) {
                 // Draw horizontal lines
                 if (j < cols - 1) {
+                    sf::Color color = horizontalColors[i * (cols - 1) + j];
                     sf::Vertex line[] = {
-                        sf::Vertex(points[i][j], getLineColor(points[i][j], points[i][j+1])),
-                        sf::Vertex(points[i][j+1], getLineColor(points[i][j], points[i][j+1]))
+                        sf::Vertex(points[i][j], color),
+                        sf::Vertex(points[i][j+1], color)
                     };
-                    window.draw(line, 2, sf::Lines);
+                    target.draw(line, 2, sf::Lines);
                 }
 
                 // Draw vertical lines
                 if (i < rows - 1) {
+                    sf::Color color = verticalColors[i * cols + j];
                     sf::Vertex line[] = {
-                        sf::Vertex(points[i][j], getLineColor(points[i][j], points[i+1][j])),
-                        sf::Vertex(points[i+1][j], getLineColor(points[i][j], points[i+1][j]))
+                        sf::Vertex(points[i][j], color),
+                        sf::Vertex(points[i+1][j], color)
                     };
-                    window.draw(line, 2, sf::Lines);
+                    target.draw(line, 2, sf::Lines);
                 }
             }
         }
@@ -213,19 +247,19 @@ public:
                 circle.setOrigin(circleSize, circleSize);
                 circle.setPosition(points[i][j]);
 
-                circle.setFillColor(getColorForPoint(points[i][j]));
+                float colorPosition = colorPositions[i * cols + j];
+                circle.setFillColor(pointColors[i * cols + j]);
 
-                // Add outline
+                // Add outline in the palette color after the fill's
                 if (circleSize > pointRadius * 1.8f) {
                     circle.setOutlineThickness(1.0f);
-                    int outlineIndex = (std::distance(palette.begin(), 
-                        std::find(palette.begin(), palette.end(), circle.getFillColor())) + 1) % palette.size();
+                    int outlineIndex = (static_cast<int>(colorPosition * (palette.size() - 1)) + 1) % palette.size();
                     circle.setOutlineColor(palette[outlineIndex]);
                 } else {
                     circle.setOutlineThickness(0.0f);
                 }
 
-                window.draw(circle);
+                target.draw(circle);
             }
         }
     }
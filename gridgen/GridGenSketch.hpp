@@ -0,0 +1,62 @@
+#ifndef GRIDGEN_SKETCH_HPP
+#define GRIDGEN_SKETCH_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include "GridGen.hpp"
+#include "../lib/Sketch.hpp"
+
+// A grid bent around random attractor circles, regenerated with R.
+// Headless renders show new attractors every simulated second.
+class GridGenSketch : public Sketch {
+private:
+    static constexpr int WIDTH = 800;
+    static constexpr int HEIGHT = 800;
+    static constexpr int GRID_COLUMNS = 20;
+    static constexpr int GRID_ROWS = 20;
+
+    std::string paletteName;
+    GridGen grid;
+    int frame;
+
+public:
+    static constexpr const char* NAME = "gridgen";
+    static constexpr const char* DESCRIPTION = "Grid distorted by attractor circles";
+
+    explicit GridGenSketch(SketchResources& resources)
+        : paletteName(resources.getPaletteName()),
+          grid(WIDTH, HEIGHT, GRID_COLUMNS, GRID_ROWS, paletteName, resources.nextSeed()), frame(0) {}
+
+    sf::Vector2u getSize() const override {
+        return sf::Vector2u(WIDTH, HEIGHT);
+    }
+
+    void reset() override {
+        grid.regenerate();
+        std::cout << "Regenerated artwork." << std::endl;
+    }
+
+    void update(float deltaTime, const SketchInput& input) override {
+        if (input.hasMouse || deltaTime <= 0.0f) {
+            return;
+        }
+        const int framesPerGrid = std::max(1, static_cast<int>(std::lround(1.0f / deltaTime)));
+        if (frame > 0 && frame % framesPerGrid == 0) {
+            grid.regenerate();
+        }
+        frame++;
+    }
+
+    void draw(sf::RenderTarget& target) override {
+        grid.draw(target);
+    }
+
+    std::string getStatus() const override {
+        return "Palette: " + paletteName;
+    }
+};
+
+#endif // GRIDGEN_SKETCH_HPP
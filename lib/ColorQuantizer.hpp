@@ -0,0 +1,337 @@
+#ifndef COLOR_QUANTIZER_HPP
+#define COLOR_QUANTIZER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <set>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Median-cut quantizer over a 5-bit-per-channel (32x32x32) histogram.
+// All working storage is fixed size, so quantizing a frame never grows
+// memory with image size or recording length.
+class MedianCutQuantizer {
+private:
+    static constexpr int CELLS = 32 * 32 * 32;
+
+    struct Box {
+        int begin;
+        int end;
+        uint64_t population;
+        int axis;
+        int extent;
+    };
+
+    std::vector<uint32_t> histogram;
+    std::vector<int> occupied;
+    std::vector<uint8_t> lookup;
+    std::vector<sf::Color> palette;
+
+    static int cellIndex(const uint8_t* pixel) {
+        return ((pixel[0] >> 3) << 10) | ((pixel[1] >> 3) << 5) | (pixel[2] >> 3);
+    }
+
+    static int channelOf(int cell, int channel) {
+        return (cell >> (10 - channel * 5)) & 31;
+    }
+
+    Box makeBox(int begin, int end, uint64_t population) const {
+        Box box = {begin, end, population, 0, 0};
+        box.extent = longestAxis(box, box.axis);
+        return box;
+    }
+
+    // Longest channel extent of the box, returned through 'channel'
+    int longestAxis(const Box& box, int& channel) const {
+        int lo[3] = {31, 31, 31};
+        int hi[3] = {0, 0, 0};
+        for (int i = box.begin; i < box.end; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                int v = channelOf(occupied[i], c);
+                lo[c] = std::min(lo[c], v);
+                hi[c] = std::max(hi[c], v);
+            }
+        }
+        channel = 0;
+        for (int c = 1; c < 3; ++c) {
+            if (hi[c] - lo[c] > hi[channel] - lo[channel]) {
+                channel = c;
+            }
+        }
+        return hi[channel] - lo[channel];
+    }
+
+public:
+    MedianCutQuantizer() : histogram(CELLS), lookup(CELLS, 0) {
+        occupied.reserve(CELLS);
+    }
+
+    // Builds a palette of at most maxColors entries for the given RGBA pixels
+    void quantize(const uint8_t* rgba, size_t pixelCount, int maxColors = 256) {
+        std::fill(histogram.begin(), histogram.end(), 0u);
+        for (size_t i = 0; i < pixelCount; ++i) {
+            histogram[cellIndex(rgba + i * 4)]++;
+        }
+
+        occupied.clear();
+        for (int cell = 0; cell < CELLS; ++cell) {
+            if (histogram[cell] > 0) {
+                occupied.push_back(cell);
+            }
+        }
+
+        std::vector<Box> boxes;
+        boxes.push_back(makeBox(0, static_cast<int>(occupied.size()), pixelCount));
+
+        while (static_cast<int>(boxes.size()) < maxColors) {
+            // Split the box with the largest population x extent score that
+            // still spans more than one cell
+            int target = -1;
+            uint64_t bestScore = 0;
+            for (int i = 0; i < static_cast<int>(boxes.size()); ++i) {
+                if (boxes[i].end - boxes[i].begin < 2) {
+                    continue;
+                }
+                uint64_t score = boxes[i].population * static_cast<uint64_t>(boxes[i].extent + 1);
+                if (target < 0 || score > bestScore) {
+                    target = i;
+                    bestScore = score;
+                }
+            }
+            if (target < 0) {
+                break;
+            }
+
+            Box box = boxes[target];
+            int channel = box.axis;
+            std::sort(occupied.begin() + box.begin, occupied.begin() + box.end,
+                      [channel](int a, int b) { return channelOf(a, channel) < channelOf(b, channel); });
+
+            // Median by pixel population, keeping at least one cell on each side
+            uint64_t half = box.population / 2;
+            uint64_t running = 0;
+            int split = box.begin + 1;
+            for (int i = box.begin; i < box.end - 1; ++i) {
+                running += histogram[occupied[i]];
+                split = i + 1;
+                if (running >= half) {
+                    break;
+                }
+            }
+
+            uint64_t lowerPopulation = 0;
+            for (int i = box.begin; i < split; ++i) {
+                lowerPopulation += histogram[occupied[i]];
+            }
+            boxes[target] = makeBox(box.begin, split, lowerPopulation);
+            boxes.push_back(makeBox(split, box.end, box.population - lowerPopulation));
+        }
+
+        // Each box becomes the population-weighted mean of its cells
+        palette.clear();
+        for (int b = 0; b < static_cast<int>(boxes.size()); ++b) {
+            uint64_t sum[3] = {0, 0, 0};
+            uint64_t count = 0;
+            for (int i = boxes[b].begin; i < boxes[b].end; ++i) {
+                int cell = occupied[i];
+                uint32_t weight = histogram[cell];
+                for (int c = 0; c < 3; ++c) {
+                    sum[c] += static_cast<uint64_t>((channelOf(cell, c) << 3) | 4) * weight;
+                }
+                count += weight;
+                lookup[cell] = static_cast<uint8_t>(b);
+            }
+            if (count == 0) {
+                palette.push_back(sf::Color::Black);
+            } else {
+                palette.push_back(sf::Color(sum[0] / count, sum[1] / count, sum[2] / count));
+            }
+        }
+    }
+
+    // Maps pixels to palette indices. Colors that were not part of the
+    // quantized frame fall back to a nearest-color search for their cell.
+    void mapPixels(const uint8_t* rgba, size_t pixelCount, uint8_t* indices) {
+        for (size_t i = 0; i < pixelCount; ++i) {
+            int cell = cellIndex(rgba + i * 4);
+            if (histogram[cell] == 0) {
+                lookup[cell] = nearest(rgba + i * 4);
+                histogram[cell] = 1;
+            }
+            indices[i] = lookup[cell];
+        }
+    }
+
+    uint8_t nearest(const uint8_t* pixel) const {
+        int best = 0;
+        int bestDistance = 1 << 30;
+        for (int i = 0; i < static_cast<int>(palette.size()); ++i) {
+            int dr = pixel[0] - palette[i].r;
+            int dg = pixel[1] - palette[i].g;
+            int db = pixel[2] - palette[i].b;
+            int distance = dr * dr + dg * dg + db * db;
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = i;
+            }
+        }
+        return static_cast<uint8_t>(best);
+    }
+
+    const std::vector<sf::Color>& getPalette() const {
+        return palette;
+    }
+};
+
+// Quantizer for sketches that only draw with a known palette. The palette
+// is extended with evenly spaced blends between every pair of its colors
+// (what alpha-blended strokes produce), and every 5-bit cell of RGB space
+// is resolved to its nearest entry once, up front. Mapping a frame is then
+// a single table lookup per pixel with no per-frame palette search.
+class FixedPaletteQuantizer {
+private:
+    static constexpr int CELLS = 32 * 32 * 32;
+    static constexpr int MAX_BLEND_STEPS = 15;
+
+    std::vector<sf::Color> palette;
+    std::vector<uint8_t> lookup;
+
+    // Palette as int16 lanes for the SIMD search: (r, g) pairs and (b, 0)
+    // pairs, padded to a multiple of 4 entries with unreachable colors
+    std::vector<int16_t> redGreen;
+    std::vector<int16_t> blue;
+
+    static int cellIndex(const uint8_t* pixel) {
+        return ((pixel[0] >> 3) << 10) | ((pixel[1] >> 3) << 5) | (pixel[2] >> 3);
+    }
+
+    void packPalette() {
+        size_t padded = (palette.size() + 3) / 4 * 4;
+        redGreen.assign(padded * 2, 0x3FFF);
+        blue.assign(padded * 2, 0);
+        for (size_t i = 0; i < palette.size(); ++i) {
+            redGreen[i * 2] = palette[i].r;
+            redGreen[i * 2 + 1] = palette[i].g;
+            blue[i * 2] = palette[i].b;
+        }
+    }
+
+public:
+    FixedPaletteQuantizer() : lookup(CELLS, 0) {}
+
+    // Builds the palette from 'colors' and 'background' plus blends between
+    // every pair. blendSteps = 0 uses as many steps as fit in 256 entries.
+    void setPalette(const std::vector<sf::Color>& colors, sf::Color background = sf::Color::Black,
+                    int blendSteps = 0) {
+        std::vector<sf::Color> base;
+        std::set<uint32_t> seen;
+        auto add = [&](std::vector<sf::Color>& target, sf::Color c) {
+            if (target.size() < 256 && seen.insert((c.r << 16) | (c.g << 8) | c.b).second) {
+                target.push_back(sf::Color(c.r, c.g, c.b));
+            }
+        };
+        add(base, background);
+        for (const sf::Color& c : colors) {
+            add(base, c);
+        }
+
+        size_t pairs = base.size() * (base.size() - 1) / 2;
+        if (blendSteps <= 0) {
+            blendSteps = pairs > 0 ? static_cast<int>((256 - base.size()) / pairs) : 0;
+            blendSteps = std::min(blendSteps, MAX_BLEND_STEPS);
+        }
+
+        palette = base;
+        for (int step = 1; step <= blendSteps; ++step) {
+            float t = static_cast<float>(step) / (blendSteps + 1);
+            for (size_t a = 0; a < base.size(); ++a) {
+                for (size_t b = a + 1; b < base.size(); ++b) {
+                    add(palette, sf::Color(
+                        static_cast<sf::Uint8>(base[a].r + (base[b].r - base[a].r) * t + 0.5f),
+                        static_cast<sf::Uint8>(base[a].g + (base[b].g - base[a].g) * t + 0.5f),
+                        static_cast<sf::Uint8>(base[a].b + (base[b].b - base[a].b) * t + 0.5f)));
+                }
+            }
+        }
+        packPalette();
+
+        for (int cell = 0; cell < CELLS; ++cell) {
+            uint8_t center[3] = {
+                static_cast<uint8_t>(((cell >> 10) << 3) | 4),
+                static_cast<uint8_t>((((cell >> 5) & 31) << 3) | 4),
+                static_cast<uint8_t>(((cell & 31) << 3) | 4)
+            };
+            lookup[cell] = nearest(center);
+        }
+    }
+
+    void mapPixels(const uint8_t* rgba, size_t pixelCount, uint8_t* indices) const {
+        for (size_t i = 0; i < pixelCount; ++i) {
+            indices[i] = lookup[cellIndex(rgba + i * 4)];
+        }
+    }
+
+    // Exact nearest palette entry by squared RGB distance; ties go to the
+    // lowest index, the same as MedianCutQuantizer::nearest
+    uint8_t nearest(const uint8_t* pixel) const {
+        int count = static_cast<int>(palette.size());
+        int i = 0;
+        int best = 0;
+        int bestDistance = 1 << 30;
+#if defined(__SSE2__)
+        if (count >= 4) {
+            const __m128i queryRG = _mm_set1_epi32((pixel[1] << 16) | pixel[0]);
+            const __m128i queryB = _mm_set1_epi32(pixel[2]);
+            __m128i laneBest = _mm_set1_epi32(1 << 30);
+            __m128i laneIndex = _mm_setzero_si128();
+            __m128i index = _mm_set_epi32(3, 2, 1, 0);
+            const __m128i four = _mm_set1_epi32(4);
+
+            int padded = static_cast<int>(redGreen.size() / 2);
+            for (int e = 0; e < padded; e += 4) {
+                __m128i rg = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&redGreen[e * 2])), queryRG);
+                __m128i b = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&blue[e * 2])), queryB);
+                __m128i distance = _mm_add_epi32(_mm_madd_epi16(rg, rg), _mm_madd_epi16(b, b));
+                __m128i closer = _mm_cmplt_epi32(distance, laneBest);
+                laneBest = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, laneBest));
+                laneIndex = _mm_or_si128(_mm_and_si128(closer, index), _mm_andnot_si128(closer, laneIndex));
+                index = _mm_add_epi32(index, four);
+            }
+
+            alignas(16) int32_t distances[4];
+            alignas(16) int32_t indicesOut[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(distances), laneBest);
+            _mm_store_si128(reinterpret_cast<__m128i*>(indicesOut), laneIndex);
+            for (int lane = 0; lane < 4; ++lane) {
+                if (distances[lane] < bestDistance ||
+                    (distances[lane] == bestDistance && indicesOut[lane] < best)) {
+                    bestDistance = distances[lane];
+                    best = indicesOut[lane];
+                }
+            }
+            i = count;
+        }
+#endif
+        for (; i < count; ++i) {
+            int dr = pixel[0] - palette[i].r;
+            int dg = pixel[1] - palette[i].g;
+            int db = pixel[2] - palette[i].b;
+            int distance = dr * dr + dg * dg + db * db;
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = i;
+            }
+        }
+        return static_cast<uint8_t>(best);
+    }
+
+    const std::vector<sf::Color>& getPalette() const {
+        return palette;
+    }
+};
+
+#endif // COLOR_QUANTIZER_HPP
@@ -0,0 +1,89 @@
+#ifndef FIXED_TIMESTEP_HPP
+#define FIXED_TIMESTEP_HPP
+
+#include <algorithm>
+#include <cstdint>
+
+// Turns variable frame times into a whole number of fixed simulation
+// steps. Leftover time carries over to the next frame, and getAlpha() says
+// how far the render time is between the last two simulation states.
+//
+// At most maxSubsteps run per frame: after a hitch the simulation falls
+// behind (the time is dropped) instead of taking ever longer steps to
+// catch up, which would make the next frame slower still.
+class FixedTimestep {
+private:
+    double step;
+    int maxSubsteps;
+    double accumulator;
+    int lastSubsteps;
+    uint64_t droppedSteps;
+
+public:
+    explicit FixedTimestep(float hz = 60.0f, int maxSubsteps = 4)
+        : step(1.0 / std::max(1.0f, hz)), maxSubsteps(std::max(1, maxSubsteps)), accumulator(0.0),
+          lastSubsteps(0), droppedSteps(0) {}
+
+    void setRate(float hz) {
+        step = 1.0 / std::max(1.0f, hz);
+        accumulator = std::min(accumulator, step);
+    }
+
+    float getRate() const {
+        return static_cast<float>(1.0 / step);
+    }
+
+    float getStep() const {
+        return static_cast<float>(step);
+    }
+
+    void setMaxSubsteps(int substeps) {
+        maxSubsteps = std::max(1, substeps);
+    }
+
+    int getMaxSubsteps() const {
+        return maxSubsteps;
+    }
+
+    void reset() {
+        accumulator = 0.0;
+        lastSubsteps = 0;
+        droppedSteps = 0;
+    }
+
+    // Adds a frame's time; returns the number of steps to run for it
+    int advance(float frameSeconds) {
+        accumulator += std::max(0.0f, frameSeconds);
+
+        // Frame times that are exact multiples of the step (headless
+        // renders) must not lose a step to rounding
+        const double epsilon = step * 1e-6;
+        int steps = static_cast<int>((accumulator + epsilon) / step);
+        if (steps > maxSubsteps) {
+            droppedSteps += steps - maxSubsteps;
+            steps = maxSubsteps;
+            accumulator = 0.0;
+        } else {
+            accumulator = std::max(0.0, accumulator - steps * step);
+        }
+        lastSubsteps = steps;
+        return steps;
+    }
+
+    // Where to draw between the previous state (0) and the current one
+    // (1); renders run up to one step behind the simulation
+    float getAlpha() const {
+        return static_cast<float>(std::min(1.0, accumulator / step));
+    }
+
+    int getLastSubsteps() const {
+        return lastSubsteps;
+    }
+
+    // Steps skipped by the substep cap since the last reset
+    uint64_t getDroppedSteps() const {
+        return droppedSteps;
+    }
+};
+
+#endif // FIXED_TIMESTEP_HPP
@@ -0,0 +1,124 @@
+#ifndef FRAME_DIFF_HPP
+#define FRAME_DIFF_HPP
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Inter-frame change detection for recorded RGBA frames.
+namespace framediff {
+
+    // Byte offset of the first difference in [0, bytes), or bytes if equal
+    inline size_t firstDifference(const uint8_t* a, const uint8_t* b, size_t bytes) {
+        size_t i = 0;
+#if defined(__SSE2__)
+        for (; i + 16 <= bytes; i += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            int equal = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+            if (equal != 0xFFFF) {
+                return i + __builtin_ctz(~equal & 0xFFFF);
+            }
+        }
+#endif
+        for (; i < bytes; ++i) {
+            if (a[i] != b[i]) {
+                return i;
+            }
+        }
+        return bytes;
+    }
+
+    // Byte offset of the last difference in [0, bytes), or bytes if equal
+    inline size_t lastDifference(const uint8_t* a, const uint8_t* b, size_t bytes) {
+        size_t end = bytes;
+#if defined(__SSE2__)
+        for (; end >= 16; end -= 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + end - 16));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + end - 16));
+            int equal = _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb));
+            if (equal != 0xFFFF) {
+                return end - 16 + (31 - __builtin_clz(~equal & 0xFFFF));
+            }
+        }
+#endif
+        while (end > 0) {
+            --end;
+            if (a[end] != b[end]) {
+                return end;
+            }
+        }
+        return bytes;
+    }
+
+    // Computes the bounding rectangle of all pixels that differ between two
+    // frames of the same size. Returns false when the frames are identical.
+    //
+    // Rows are scanned from the top and bottom until the first change, and
+    // inside that band each row is only scanned up to the current left and
+    // right bounds, so a small change in a large frame touches little memory.
+    inline bool findDirtyRect(const uint8_t* previous, const uint8_t* current,
+                              unsigned int width, unsigned int height, sf::IntRect& rect) {
+        const size_t rowBytes = static_cast<size_t>(width) * 4;
+
+        unsigned int top = 0;
+        size_t firstByte = rowBytes;
+        for (; top < height; ++top) {
+            firstByte = firstDifference(previous + top * rowBytes, current + top * rowBytes, rowBytes);
+            if (firstByte < rowBytes) {
+                break;
+            }
+        }
+        if (top == height) {
+            return false;
+        }
+
+        unsigned int bottom = height - 1;
+        size_t lastByte = rowBytes;
+        for (; bottom > top; --bottom) {
+            lastByte = lastDifference(previous + bottom * rowBytes, current + bottom * rowBytes, rowBytes);
+            if (lastByte < rowBytes) {
+                break;
+            }
+        }
+
+        unsigned int left = static_cast<unsigned int>(firstByte / 4);
+        unsigned int right = static_cast<unsigned int>(lastDifference(previous + top * rowBytes,
+                                                                       current + top * rowBytes, rowBytes) / 4);
+        if (bottom != top) {
+            left = std::min(left, static_cast<unsigned int>(
+                firstDifference(previous + bottom * rowBytes, current + bottom * rowBytes, rowBytes) / 4));
+            right = std::max(right, static_cast<unsigned int>(lastByte / 4));
+        }
+
+        // Widen the bounds using only the bytes outside them
+        for (unsigned int y = top + 1; y < bottom; ++y) {
+            const uint8_t* a = previous + y * rowBytes;
+            const uint8_t* b = current + y * rowBytes;
+            if (left > 0) {
+                size_t diff = firstDifference(a, b, left * 4);
+                if (diff < left * 4) {
+                    left = static_cast<unsigned int>(diff / 4);
+                }
+            }
+            if (right + 1 < width) {
+                size_t offset = (right + 1) * 4;
+                size_t diff = lastDifference(a + offset, b + offset, rowBytes - offset);
+                if (diff < rowBytes - offset) {
+                    right = static_cast<unsigned int>((offset + diff) / 4);
+                }
+            }
+        }
+
+        rect = sf::IntRect(left, top, right - left + 1, bottom - top + 1);
+        return true;
+    }
+}
+
+#endif // FRAME_DIFF_HPP
@@ -0,0 +1,132 @@
+#ifndef FRAME_QUEUE_HPP
+#define FRAME_QUEUE_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+// A captured frame waiting to be encoded. The pixel buffer is reused
+// between frames so steady-state recording does not allocate.
+struct CapturedFrame {
+    std::vector<sf::Uint8> pixels;
+    unsigned int width = 0;
+    unsigned int height = 0;
+    int index = 0;
+    // Region that changed since the previous frame (the whole frame for
+    // the first one) and how many capture intervals the frame stays on screen
+    sf::IntRect dirty;
+    int duration = 1;
+};
+
+// Bounded pool of reusable frame buffers shared by the render thread
+// (producer) and the encode workers (consumers).
+//
+// acquire() never blocks: when every buffer is in use the caller is
+// expected to drop the frame instead of stalling the render loop.
+// Offline rendering, which must keep every frame, uses acquireWait().
+class FrameQueue {
+private:
+    std::vector<std::unique_ptr<CapturedFrame>> storage;
+    std::vector<CapturedFrame*> freeBuffers;
+    std::deque<CapturedFrame*> pending;
+    mutable std::mutex mutex;
+    std::condition_variable frameReady;
+    std::condition_variable bufferFree;
+    bool closed;
+    size_t peakDepth;
+
+public:
+    explicit FrameQueue(size_t capacity) : closed(false), peakDepth(0) {
+        if (capacity == 0) {
+            capacity = 1;
+        }
+        for (size_t i = 0; i < capacity; ++i) {
+            storage.push_back(std::make_unique<CapturedFrame>());
+            freeBuffers.push_back(storage.back().get());
+        }
+    }
+
+    // Returns a free buffer, or nullptr if all buffers are queued or being encoded
+    CapturedFrame* acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (freeBuffers.empty()) {
+            return nullptr;
+        }
+        CapturedFrame* frame = freeBuffers.back();
+        freeBuffers.pop_back();
+        return frame;
+    }
+
+    // Blocks until an encode worker hands a buffer back
+    CapturedFrame* acquireWait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        bufferFree.wait(lock, [this] { return !freeBuffers.empty(); });
+        CapturedFrame* frame = freeBuffers.back();
+        freeBuffers.pop_back();
+        return frame;
+    }
+
+    void push(CapturedFrame* frame) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending.push_back(frame);
+            peakDepth = std::max(peakDepth, pending.size());
+        }
+        frameReady.notify_one();
+    }
+
+    // Blocks until a frame is available. Returns nullptr once the queue
+    // has been closed and fully drained.
+    CapturedFrame* pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        frameReady.wait(lock, [this] { return closed || !pending.empty(); });
+        if (pending.empty()) {
+            return nullptr;
+        }
+        CapturedFrame* frame = pending.front();
+        pending.pop_front();
+        return frame;
+    }
+
+    void release(CapturedFrame* frame) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeBuffers.push_back(frame);
+        }
+        bufferFree.notify_one();
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        frameReady.notify_all();
+    }
+
+    void reopen() {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = false;
+        peakDepth = 0;
+    }
+
+    size_t depth() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pending.size();
+    }
+
+    size_t getPeakDepth() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return peakDepth;
+    }
+
+    size_t capacity() const {
+        return storage.size();
+    }
+};
+
+#endif // FRAME_QUEUE_HPP
@@ -0,0 +1,255 @@
+#ifndef FRAME_SINK_HPP
+#define FRAME_SINK_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <filesystem>
+#include <memory>
+#include "FrameQueue.hpp"
+#include "GIFEncoder.hpp"
+#include "FrameSpool.hpp"
+#include "Y4MWriter.hpp"
+#include "ImageWriter.hpp"
+
+// Destination for recorded frames. GIFRecorder owns one sink per
+// recording and feeds it from its encode workers.
+class FrameSink {
+public:
+    virtual ~FrameSink() {}
+
+    virtual bool begin(unsigned int width, unsigned int height, float fps) = 0;
+    virtual bool writeFrame(const CapturedFrame& frame) = 0;
+    virtual void finish() = 0;
+
+    // Ordered sinks receive frames one at a time in capture order; the
+    // others may be called concurrently from several workers.
+    virtual bool isOrdered() const {
+        return true;
+    }
+
+    // Sinks that honour CapturedFrame::dirty and ::duration. The recorder
+    // only skips identical frames for these; the others get every capture.
+    virtual bool acceptsDeltaFrames() const {
+        return false;
+    }
+
+    // Shown in the summary printed when recording stops
+    virtual std::string describe() const = 0;
+};
+
+// One image file per frame in a directory
+class ImageSequenceSink : public FrameSink {
+private:
+    std::string directory;
+    std::unique_ptr<ImageWriter> writer;
+
+public:
+    explicit ImageSequenceSink(const std::string& dir = "frames", ImageFormat format = ImageFormat::PNG)
+        : directory(dir), writer(ImageWriter::create(format)) {}
+
+    bool begin(unsigned int, unsigned int, float) override {
+        std::filesystem::create_directory(directory);
+        return true;
+    }
+
+    bool writeFrame(const CapturedFrame& frame) override {
+        std::stringstream filename;
+        filename << directory << "/frame_" << std::setw(4) << std::setfill('0') << frame.index << writer->extension();
+
+        if (!writer->write(filename.str(), frame.pixels.data(), frame.width, frame.height)) {
+            std::cerr << "Failed to save " << filename.str() << '\n';
+            return false;
+        }
+        return true;
+    }
+
+    void finish() override {}
+
+    bool isOrdered() const override {
+        return false;
+    }
+
+    std::string describe() const override {
+        return "the '" + directory + "' directory";
+    }
+};
+
+// Streams frames straight into an animated GIF
+class GIFSink : public FrameSink {
+private:
+    std::string path;
+    GIFPaletteMode paletteMode;
+    std::shared_ptr<const FixedPaletteQuantizer> fixedPalette;
+    GIFEncoder encoder;
+    unsigned int width;
+    unsigned int height;
+    float frameSeconds;
+
+public:
+    explicit GIFSink(const std::string& file = "animation.gif", GIFPaletteMode mode = GIFPaletteMode::Global)
+        : path(file), paletteMode(mode), width(0), height(0), frameSeconds(1.0f / 30.0f) {}
+
+    // Switches to GIFPaletteMode::Fixed with a prebuilt palette lookup
+    GIFSink(const std::string& file, std::shared_ptr<const FixedPaletteQuantizer> palette)
+        : path(file), paletteMode(GIFPaletteMode::Fixed), fixedPalette(std::move(palette)),
+          width(0), height(0), frameSeconds(1.0f / 30.0f) {
+        encoder.setFixedPalette(fixedPalette.get());
+    }
+
+    bool begin(unsigned int w, unsigned int h, float fps) override {
+        width = w;
+        height = h;
+        frameSeconds = 1.0f / fps;
+        if (!encoder.open(path, width, height, paletteMode)) {
+            std::cerr << "Failed to open " << path << " for writing." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool writeFrame(const CapturedFrame& frame) override {
+        // The canvas size is fixed when the file is opened
+        if (frame.width != width || frame.height != height) {
+            std::cerr << "Skipping frame " << frame.index << ": size does not match the GIF canvas\n";
+            return false;
+        }
+        return encoder.addFrame(frame.pixels.data(), frame.dirty, encoder.delayFor(frameSeconds * frame.duration));
+    }
+
+    void finish() override {
+        encoder.close();
+    }
+
+    bool acceptsDeltaFrames() const override {
+        return true;
+    }
+
+    std::string describe() const override {
+        return path;
+    }
+};
+
+// Appends raw frames to a memory-mapped spool file for encoding later
+class SpoolSink : public FrameSink {
+private:
+    std::string path;
+    FrameSpoolWriter writer;
+    unsigned int width;
+    unsigned int height;
+
+public:
+    explicit SpoolSink(const std::string& file = "recording.spool") : path(file), width(0), height(0) {}
+
+    bool begin(unsigned int w, unsigned int h, float fps) override {
+        width = w;
+        height = h;
+        return writer.open(path, w, h, fps);
+    }
+
+    bool writeFrame(const CapturedFrame& frame) override {
+        if (frame.width != width || frame.height != height) {
+            std::cerr << "Skipping frame " << frame.index << ": size does not match the spool\n";
+            return false;
+        }
+        SpoolFrameInfo info = {frame.dirty.left, frame.dirty.top, frame.dirty.width, frame.dirty.height,
+                               static_cast<uint32_t>(frame.duration), 0, {0, 0}};
+        return writer.append(frame.pixels.data(), info);
+    }
+
+    void finish() override {
+        writer.close();
+    }
+
+    bool acceptsDeltaFrames() const override {
+        return true;
+    }
+
+    std::string describe() const override {
+        return path;
+    }
+};
+
+// Uncompressed 4:2:0 video for external encoders. Unchanged frames are
+// written once per capture interval they cover, so timing is preserved.
+class Y4MSink : public FrameSink {
+private:
+    std::string path;
+    Y4MWriter writer;
+    unsigned int width;
+    unsigned int height;
+
+public:
+    explicit Y4MSink(const std::string& file = "recording.y4m") : path(file), width(0), height(0) {}
+
+    bool begin(unsigned int w, unsigned int h, float fps) override {
+        width = w;
+        height = h;
+        return writer.open(path, w, h, fps);
+    }
+
+    bool writeFrame(const CapturedFrame& frame) override {
+        if (frame.width != width || frame.height != height) {
+            std::cerr << "Skipping frame " << frame.index << ": size does not match the video\n";
+            return false;
+        }
+        return writer.writeFrame(frame.pixels.data(), std::max(1, frame.duration));
+    }
+
+    void finish() override {
+        writer.close();
+    }
+
+    bool acceptsDeltaFrames() const override {
+        return true;
+    }
+
+    std::string describe() const override {
+        return path == "-" ? "stdout" : path;
+    }
+};
+
+// Feeds every frame of a spool file through another sink, e.g. to turn a
+// long raw capture into a GIF once recording is over
+inline int encodeSpool(const std::string& spoolPath, FrameSink& sink) {
+    FrameSpoolReader reader;
+    if (!reader.open(spoolPath)) {
+        return 0;
+    }
+    if (!sink.begin(reader.getWidth(), reader.getHeight(), reader.getFPS())) {
+        return 0;
+    }
+
+    CapturedFrame frame;
+    frame.width = reader.getWidth();
+    frame.height = reader.getHeight();
+    size_t frameBytes = static_cast<size_t>(frame.width) * frame.height * 4;
+
+    // Output frames are numbered in write order, so repeats never collide
+    int written = 0;
+    int next = 0;
+    for (uint64_t i = 0; i < reader.getFrameCount(); ++i) {
+        const uint8_t* pixels = reader.frame(i);
+        SpoolFrameInfo info = reader.frameInfo(i);
+        frame.pixels.assign(pixels, pixels + frameBytes);
+
+        // Sinks without delta support get full frames, repeated for their duration
+        int repeats = sink.acceptsDeltaFrames() ? 1 : static_cast<int>(std::max(1u, info.duration));
+        frame.duration = sink.acceptsDeltaFrames() ? static_cast<int>(info.duration) : 1;
+        frame.dirty = sink.acceptsDeltaFrames()
+            ? sf::IntRect(info.left, info.top, info.width, info.height)
+            : sf::IntRect(0, 0, frame.width, frame.height);
+        for (int r = 0; r < repeats; ++r) {
+            frame.index = next++;
+            if (sink.writeFrame(frame)) {
+                written++;
+            }
+        }
+    }
+    sink.finish();
+    return written;
+}
+
+#endif // FRAME_SINK_HPP
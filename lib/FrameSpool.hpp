@@ -0,0 +1,413 @@
+#ifndef FRAME_SPOOL_HPP
+#define FRAME_SPOOL_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// On-disk layout of a raw frame spool:
+//
+//   [SpoolHeader, padded to one page][frame 0][frame 1]...
+//
+// Each frame is a SpoolFrameInfo followed by the RGBA rows of the region
+// that changed since the previous frame, padded to 16 bytes, so a mostly
+// static scene costs little more than its moving parts. Every
+// KEYFRAME_INTERVAL-th frame (and the first) stores the whole canvas
+// instead, which bounds how far back the reader goes to rebuild a frame.
+struct SpoolHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    float fps;
+    uint64_t frameCount;
+};
+
+// Per-frame record: the region that changed since the previous frame, how
+// many capture intervals the frame is shown for, and whether the pixels
+// that follow are the whole canvas (SPOOL_KEYFRAME) or only that region
+struct SpoolFrameInfo {
+    int32_t left;
+    int32_t top;
+    int32_t width;
+    int32_t height;
+    uint32_t duration;
+    uint32_t flags;
+    uint32_t reserved[2];
+};
+
+constexpr uint32_t SPOOL_KEYFRAME = 1;
+
+namespace spool {
+    constexpr char MAGIC[8] = {'G', 'A', 'S', 'P', 'O', 'O', 'L', '1'};
+    constexpr uint32_t VERSION = 3;
+    constexpr uint64_t KEYFRAME_INTERVAL = 256;
+
+    inline size_t pageSize() {
+        static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    inline size_t roundToPage(size_t bytes) {
+        size_t page = pageSize();
+        return (bytes + page - 1) / page * page;
+    }
+
+    // Bytes a frame storing a width x height region takes
+    inline size_t recordBytes(int32_t width, int32_t height) {
+        size_t pixels = static_cast<size_t>(std::max(0, width)) * std::max(0, height) * 4;
+        return (sizeof(SpoolFrameInfo) + pixels + 15) / 16 * 16;
+    }
+
+    // The pixels a frame stores, as left, top, width, height: its changed
+    // region within the canvas, or the whole canvas for a keyframe
+    inline void storedRegion(const SpoolFrameInfo& info, uint32_t canvasWidth, uint32_t canvasHeight,
+                             int32_t region[4]) {
+        const int32_t width = static_cast<int32_t>(canvasWidth);
+        const int32_t height = static_cast<int32_t>(canvasHeight);
+        if (info.flags & SPOOL_KEYFRAME) {
+            region[0] = 0;
+            region[1] = 0;
+            region[2] = width;
+            region[3] = height;
+            return;
+        }
+        region[0] = std::min(width, std::max(0, info.left));
+        region[1] = std::min(height, std::max(0, info.top));
+        region[2] = std::max(0, std::min(width, info.left + info.width) - region[0]);
+        region[3] = std::max(0, std::min(height, info.top + info.height) - region[1]);
+    }
+
+    // The most a frame can take: a keyframe
+    inline size_t frameStride(uint32_t width, uint32_t height) {
+        return recordBytes(static_cast<int32_t>(width), static_cast<int32_t>(height));
+    }
+
+    inline size_t dataOffset() {
+        return roundToPage(sizeof(SpoolHeader));
+    }
+}
+
+// Append-only writer. Frames are copied into a small memory-mapped window
+// that slides along the file, so resident memory stays at a few frames no
+// matter how long the recording runs.
+class FrameSpoolWriter {
+private:
+    static constexpr size_t FRAMES_PER_WINDOW = 8;
+
+    int fd;
+    SpoolHeader* header;
+    uint8_t* window;
+    size_t windowOffset;
+    size_t windowBytes;
+    size_t writeOffset;
+
+    void unmapWindow() {
+        if (window) {
+            munmap(window, windowBytes);
+            window = nullptr;
+        }
+    }
+
+    // Maps enough for several keyframes from the page holding 'offset'
+    bool mapWindow(size_t offset) {
+        unmapWindow();
+        size_t start = offset / spool::pageSize() * spool::pageSize();
+        size_t bytes = spool::roundToPage(FRAMES_PER_WINDOW * spool::frameStride(header->width, header->height) +
+                                          spool::pageSize());
+
+        if (ftruncate(fd, static_cast<off_t>(start + bytes)) != 0) {
+            std::cerr << "Spool: could not grow file (disk full?)" << std::endl;
+            return false;
+        }
+        void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(start));
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Spool: mmap failed" << std::endl;
+            return false;
+        }
+        window = static_cast<uint8_t*>(mapped);
+        windowOffset = start;
+        windowBytes = bytes;
+        return true;
+    }
+
+public:
+    FrameSpoolWriter() : fd(-1), header(nullptr), window(nullptr), windowOffset(0), windowBytes(0),
+        writeOffset(0) {}
+
+    ~FrameSpoolWriter() {
+        close();
+    }
+
+    bool open(const std::string& path, uint32_t width, uint32_t height, float fps) {
+        close();
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cerr << "Spool: could not open " << path << std::endl;
+            return false;
+        }
+
+        size_t headerBytes = spool::dataOffset();
+        if (ftruncate(fd, static_cast<off_t>(headerBytes)) != 0) {
+            close();
+            return false;
+        }
+        void* mapped = mmap(nullptr, headerBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Spool: mmap failed" << std::endl;
+            close();
+            return false;
+        }
+
+        header = static_cast<SpoolHeader*>(mapped);
+        std::memcpy(header->magic, spool::MAGIC, sizeof(header->magic));
+        header->version = spool::VERSION;
+        header->width = width;
+        header->height = height;
+        header->fps = fps;
+        header->frameCount = 0;
+
+        writeOffset = headerBytes;
+        return mapWindow(writeOffset);
+    }
+
+    bool isOpen() const {
+        return fd >= 0;
+    }
+
+    // rgba is the whole canvas; only info's region of it is stored, unless
+    // the frame is due to be a keyframe
+    bool append(const uint8_t* rgba, const SpoolFrameInfo& info) {
+        if (!header) {
+            return false;
+        }
+
+        SpoolFrameInfo stored = info;
+        stored.flags = header->frameCount % spool::KEYFRAME_INTERVAL == 0 ? SPOOL_KEYFRAME : 0;
+        int32_t region[4];
+        spool::storedRegion(stored, header->width, header->height, region);
+        const size_t bytes = spool::recordBytes(region[2], region[3]);
+
+        if (writeOffset + bytes > windowOffset + windowBytes) {
+            // Hand the finished window to the kernel for write-back
+            msync(window, windowBytes, MS_ASYNC);
+            if (!mapWindow(writeOffset)) {
+                return false;
+            }
+        }
+
+        uint8_t* slot = window + (writeOffset - windowOffset);
+        std::memcpy(slot, &stored, sizeof(stored));
+        uint8_t* out = slot + sizeof(stored);
+        const size_t rowBytes = static_cast<size_t>(region[2]) * 4;
+        for (int32_t y = region[1]; y < region[1] + region[3]; ++y) {
+            std::memcpy(out, rgba + (static_cast<size_t>(y) * header->width + region[0]) * 4, rowBytes);
+            out += rowBytes;
+        }
+        writeOffset += bytes;
+        header->frameCount++;
+        return true;
+    }
+
+    uint64_t getFrameCount() const {
+        return header ? header->frameCount : 0;
+    }
+
+    void close() {
+        if (fd < 0) {
+            return;
+        }
+        size_t finalSize = std::max(writeOffset, spool::dataOffset());
+        unmapWindow();
+        if (header) {
+            msync(header, spool::dataOffset(), MS_SYNC);
+            munmap(header, spool::dataOffset());
+            header = nullptr;
+        }
+        // Drop the unused tail of the last window
+        if (ftruncate(fd, static_cast<off_t>(finalSize)) != 0) {
+            std::cerr << "Spool: could not trim file" << std::endl;
+        }
+        ::close(fd);
+        fd = -1;
+        writeOffset = 0;
+    }
+
+    // Number of frames of the given size that fit in the free space of the
+    // filesystem holding 'path', keeping 'reserveBytes' free, if every one
+    // were a keyframe
+    static uint64_t framesThatFit(const std::string& path, uint32_t width, uint32_t height,
+                                  uint64_t reserveBytes = 256ull * 1024 * 1024) {
+        std::error_code error;
+        std::filesystem::path dir = std::filesystem::absolute(path, error).parent_path();
+        std::filesystem::space_info info = std::filesystem::space(dir, error);
+        if (error || info.available <= reserveBytes) {
+            return 0;
+        }
+        return (info.available - reserveBytes) / spool::frameStride(width, height);
+    }
+};
+
+// Read-only view of a spool file. The whole file is mapped; pages are
+// faulted in on demand. open() finds where each frame starts, and frame()
+// rebuilds a whole canvas from the nearest keyframe or, when reading in
+// order, from the frame before.
+class FrameSpoolReader {
+private:
+    int fd;
+    uint8_t* data;
+    size_t size;
+    SpoolHeader header;
+    std::vector<size_t> offsets;
+    std::vector<uint64_t> keyframes;
+    std::vector<uint8_t> canvas;
+    int64_t canvasFrame;
+
+    SpoolFrameInfo storedInfo(uint64_t i) const {
+        SpoolFrameInfo info;
+        std::memcpy(&info, data + offsets[i], sizeof(info));
+        return info;
+    }
+
+    // Copies frame i's stored pixels over the canvas
+    void apply(uint64_t i) {
+        SpoolFrameInfo info = storedInfo(i);
+        int32_t region[4];
+        spool::storedRegion(info, header.width, header.height, region);
+        const uint8_t* in = data + offsets[i] + sizeof(info);
+        const size_t rowBytes = static_cast<size_t>(region[2]) * 4;
+        for (int32_t y = region[1]; y < region[1] + region[3]; ++y) {
+            std::memcpy(canvas.data() + (static_cast<size_t>(y) * header.width + region[0]) * 4, in, rowBytes);
+            in += rowBytes;
+        }
+    }
+
+public:
+    FrameSpoolReader() : fd(-1), data(nullptr), size(0), header(), canvasFrame(-1) {}
+
+    ~FrameSpoolReader() {
+        close();
+    }
+
+    bool open(const std::string& path) {
+        close();
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Spool: could not open " << path << std::endl;
+            return false;
+        }
+
+        off_t fileSize = lseek(fd, 0, SEEK_END);
+        if (fileSize < static_cast<off_t>(spool::dataOffset())) {
+            std::cerr << "Spool: " << path << " is truncated" << std::endl;
+            close();
+            return false;
+        }
+
+        size = static_cast<size_t>(fileSize);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "Spool: mmap failed" << std::endl;
+            close();
+            return false;
+        }
+        data = static_cast<uint8_t*>(mapped);
+        std::memcpy(&header, data, sizeof(header));
+
+        if (std::memcmp(header.magic, spool::MAGIC, sizeof(header.magic)) != 0 || header.version != spool::VERSION) {
+            std::cerr << "Spool: " << path << " is not a frame spool" << std::endl;
+            close();
+            return false;
+        }
+
+        // Writer may not have shut down cleanly; keep the frames that made
+        // it to disk whole
+        size_t offset = spool::dataOffset();
+        while (offsets.size() < header.frameCount && offset + sizeof(SpoolFrameInfo) <= size) {
+            SpoolFrameInfo info;
+            std::memcpy(&info, data + offset, sizeof(info));
+            int32_t region[4];
+            spool::storedRegion(info, header.width, header.height, region);
+            size_t bytes = spool::recordBytes(region[2], region[3]);
+            if (offset + bytes > size) {
+                break;
+            }
+            if (info.flags & SPOOL_KEYFRAME) {
+                keyframes.push_back(offsets.size());
+            }
+            offsets.push_back(offset);
+            offset += bytes;
+        }
+        header.frameCount = offsets.size();
+        canvas.assign(static_cast<size_t>(header.width) * header.height * 4, 0);
+        madvise(data, size, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void close() {
+        if (data) {
+            munmap(data, size);
+            data = nullptr;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        offsets.clear();
+        keyframes.clear();
+        canvasFrame = -1;
+    }
+
+    uint32_t getWidth() const {
+        return header.width;
+    }
+
+    uint32_t getHeight() const {
+        return header.height;
+    }
+
+    float getFPS() const {
+        return header.fps;
+    }
+
+    uint64_t getFrameCount() const {
+        return header.frameCount;
+    }
+
+    // RGBA pixels of the whole of frame i, valid until the next call
+    const uint8_t* frame(uint64_t i) {
+        if (!data || i >= header.frameCount) {
+            return nullptr;
+        }
+        auto keyframe = std::upper_bound(keyframes.begin(), keyframes.end(), i);
+        uint64_t start = keyframe != keyframes.begin() ? *(keyframe - 1) : 0;
+        if (canvasFrame >= static_cast<int64_t>(start) && canvasFrame <= static_cast<int64_t>(i)) {
+            start = static_cast<uint64_t>(canvasFrame) + 1;
+        } else if (keyframe == keyframes.begin()) {
+            std::fill(canvas.begin(), canvas.end(), 0);
+        }
+        for (uint64_t f = start; f <= i; ++f) {
+            apply(f);
+        }
+        canvasFrame = static_cast<int64_t>(i);
+        return canvas.data();
+    }
+
+    // The changed region and duration of frame i, as captured
+    SpoolFrameInfo frameInfo(uint64_t i) const {
+        SpoolFrameInfo info = {0, 0, static_cast<int32_t>(header.width), static_cast<int32_t>(header.height), 1, 0, {0, 0}};
+        if (data && i < header.frameCount) {
+            info = storedInfo(i);
+        }
+        return info;
+    }
+};
+
+#endif // FRAME_SPOOL_HPP
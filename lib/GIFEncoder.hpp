@@ -0,0 +1,339 @@
+#ifndef GIF_ENCODER_HPP
+#define GIF_ENCODER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "ColorQuantizer.hpp"
+
+enum class GIFPaletteMode {
+    Global,     // Palette built from the first frame and shared by all frames
+    PerFrame,   // Every frame carries its own local color table
+    Fixed       // Global table from a FixedPaletteQuantizer, no per-frame search
+};
+
+// Streaming GIF89a writer. Frames are quantized, LZW-compressed and
+// written as they arrive; memory use is bounded by one frame of indices
+// and one frame of scratch pixels plus fixed-size quantizer and
+// compressor tables.
+class GIFEncoder {
+private:
+    std::ofstream file;
+    unsigned int width;
+    unsigned int height;
+    GIFPaletteMode paletteMode;
+    bool hasGlobalPalette;
+    int frameCount;
+    double delayRemainder;
+    int loopCount;
+    bool loopExtensionPending;
+
+    MedianCutQuantizer quantizer;
+    const FixedPaletteQuantizer* fixedQuantizer;
+    std::vector<uint8_t> indices;
+    std::vector<uint8_t> subImage;
+
+    // LZW state, reused between frames
+    static constexpr int MAX_CODES = 4096;
+    static constexpr int HASH_SIZE = 5003;
+    std::vector<int32_t> hashKeys;
+    std::vector<int16_t> hashCodes;
+    uint8_t block[256];
+    int blockSize;
+    uint32_t bitBuffer;
+    int bitCount;
+
+    void writeByte(uint8_t value) {
+        file.put(static_cast<char>(value));
+    }
+
+    void writeShort(uint16_t value) {
+        writeByte(value & 0xFF);
+        writeByte(value >> 8);
+    }
+
+    // Smallest n with 2^n >= colors, at least 1 (color tables hold 2^n entries)
+    static int tableBits(size_t colors) {
+        int bits = 1;
+        while ((1u << bits) < colors) {
+            bits++;
+        }
+        return bits;
+    }
+
+    void writeColorTable(const std::vector<sf::Color>& colors, int bits) {
+        for (int i = 0; i < (1 << bits); ++i) {
+            sf::Color c = i < static_cast<int>(colors.size()) ? colors[i] : sf::Color::Black;
+            writeByte(c.r);
+            writeByte(c.g);
+            writeByte(c.b);
+        }
+    }
+
+    void flushBlock() {
+        if (blockSize > 0) {
+            writeByte(static_cast<uint8_t>(blockSize));
+            file.write(reinterpret_cast<const char*>(block), blockSize);
+            blockSize = 0;
+        }
+    }
+
+    void emitCode(int code, int codeSize) {
+        bitBuffer |= static_cast<uint32_t>(code) << bitCount;
+        bitCount += codeSize;
+        while (bitCount >= 8) {
+            block[blockSize++] = bitBuffer & 0xFF;
+            bitBuffer >>= 8;
+            bitCount -= 8;
+            if (blockSize == 255) {
+                flushBlock();
+            }
+        }
+    }
+
+    void compress(const uint8_t* data, size_t count, int minCodeSize) {
+        if (count == 0) {
+            return;
+        }
+        const int clearCode = 1 << minCodeSize;
+        const int endCode = clearCode + 1;
+        int codeSize = minCodeSize + 1;
+        int nextCode = endCode + 1;
+
+        blockSize = 0;
+        bitBuffer = 0;
+        bitCount = 0;
+        std::fill(hashKeys.begin(), hashKeys.end(), -1);
+
+        writeByte(static_cast<uint8_t>(minCodeSize));
+        emitCode(clearCode, codeSize);
+
+        int prefix = data[0];
+        for (size_t i = 1; i < count; ++i) {
+            uint8_t c = data[i];
+            int32_t key = (prefix << 8) | c;
+            int slot = static_cast<int>((static_cast<uint32_t>(c) << 12 ^ prefix) % HASH_SIZE);
+
+            while (hashKeys[slot] != -1 && hashKeys[slot] != key) {
+                slot = (slot + 1) % HASH_SIZE;
+            }
+            if (hashKeys[slot] == key) {
+                prefix = hashCodes[slot];
+                continue;
+            }
+
+            emitCode(prefix, codeSize);
+            hashKeys[slot] = key;
+            hashCodes[slot] = static_cast<int16_t>(nextCode);
+            if (nextCode >= (1 << codeSize)) {
+                codeSize++;
+            }
+            nextCode++;
+
+            if (nextCode == MAX_CODES) {
+                // Dictionary full: start over
+                emitCode(clearCode, codeSize);
+                std::fill(hashKeys.begin(), hashKeys.end(), -1);
+                codeSize = minCodeSize + 1;
+                nextCode = endCode + 1;
+            }
+            prefix = c;
+        }
+
+        emitCode(prefix, codeSize);
+        emitCode(endCode, codeSize);
+        if (bitCount > 0) {
+            block[blockSize++] = bitBuffer & 0xFF;
+            bitBuffer = 0;
+            bitCount = 0;
+            if (blockSize == 255) {
+                flushBlock();
+            }
+        }
+        flushBlock();
+        writeByte(0); // Block terminator
+    }
+
+public:
+    GIFEncoder() : width(0), height(0), paletteMode(GIFPaletteMode::Global), hasGlobalPalette(false),
+        frameCount(0), delayRemainder(0.0), loopCount(0), loopExtensionPending(false), fixedQuantizer(nullptr),
+        hashKeys(HASH_SIZE), hashCodes(HASH_SIZE),
+        blockSize(0), bitBuffer(0), bitCount(0) {}
+
+    ~GIFEncoder() {
+        close();
+    }
+
+    // Palette used by GIFPaletteMode::Fixed; must outlive the encoder's use
+    void setFixedPalette(const FixedPaletteQuantizer* fixed) {
+        fixedQuantizer = fixed;
+    }
+
+    bool open(const std::string& path, unsigned int w, unsigned int h,
+              GIFPaletteMode mode = GIFPaletteMode::Global, int loops = 0) {
+        close();
+        if (mode == GIFPaletteMode::Fixed && !fixedQuantizer) {
+            return false;
+        }
+        file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+
+        width = w;
+        height = h;
+        paletteMode = mode;
+        hasGlobalPalette = false;
+        frameCount = 0;
+        delayRemainder = 0.0;
+        loopCount = loops;
+        loopExtensionPending = true;
+        indices.resize(static_cast<size_t>(w) * h);
+
+        file.write("GIF89a", 6);
+        writeShort(static_cast<uint16_t>(width));
+        writeShort(static_cast<uint16_t>(height));
+
+        // The global color table is only known after the first frame, so the
+        // logical screen descriptor is patched then (see addFrame)
+        writeByte(0);    // Packed fields
+        writeByte(0);    // Background color index
+        writeByte(0);    // Pixel aspect ratio
+        return true;
+    }
+
+    bool isOpen() const {
+        return file.is_open();
+    }
+
+    // Converts a frame duration in seconds to GIF centiseconds, carrying the
+    // rounding error forward so 30 FPS averages out to 3.33cs per frame
+    int delayFor(float seconds) {
+        double exact = seconds * 100.0 + delayRemainder;
+        int delay = std::max(2, static_cast<int>(std::lround(exact)));
+        delayRemainder = exact - delay;
+        return delay;
+    }
+
+    // Appends one RGBA frame of size width x height
+    bool addFrame(const uint8_t* rgba, int delayCentiseconds) {
+        return addFrame(rgba, sf::IntRect(0, 0, width, height), delayCentiseconds);
+    }
+
+    // Appends only the 'region' of a full width x height RGBA frame. The
+    // rest of the canvas keeps showing the previous frames, so a mostly
+    // static scene costs only its changed area.
+    bool addFrame(const uint8_t* canvas, sf::IntRect region, int delayCentiseconds) {
+        if (!file) {
+            return false;
+        }
+
+        region.left = std::max(0, region.left);
+        region.top = std::max(0, region.top);
+        region.width = std::max(1, std::min(region.width, static_cast<int>(width) - region.left));
+        region.height = std::max(1, std::min(region.height, static_cast<int>(height) - region.top));
+
+        const uint8_t* rgba = canvas;
+        if (region.width != static_cast<int>(width) || region.height != static_cast<int>(height)) {
+            size_t rowBytes = static_cast<size_t>(region.width) * 4;
+            subImage.resize(rowBytes * region.height);
+            for (int y = 0; y < region.height; ++y) {
+                const uint8_t* row = canvas + ((static_cast<size_t>(region.top) + y) * width + region.left) * 4;
+                std::memcpy(subImage.data() + y * rowBytes, row, rowBytes);
+            }
+            rgba = subImage.data();
+        }
+
+        size_t pixelCount = static_cast<size_t>(region.width) * region.height;
+        bool writeLocalTable = true;
+        bool fixed = paletteMode == GIFPaletteMode::Fixed;
+
+        if (paletteMode == GIFPaletteMode::PerFrame || (!fixed && !hasGlobalPalette)) {
+            quantizer.quantize(rgba, pixelCount);
+        }
+
+        const std::vector<sf::Color>& colors = fixed ? fixedQuantizer->getPalette() : quantizer.getPalette();
+        int bits = tableBits(colors.size());
+
+        if (paletteMode != GIFPaletteMode::PerFrame) {
+            writeLocalTable = false;
+            if (!hasGlobalPalette) {
+                // Patch the logical screen descriptor and append the global table
+                std::streampos tablePos = file.tellp();
+                file.seekp(10);
+                writeByte(static_cast<uint8_t>(0x80 | ((bits - 1) << 4) | (bits - 1)));
+                file.seekp(tablePos);
+                writeColorTable(colors, bits);
+                hasGlobalPalette = true;
+
+                if (loopExtensionPending) {
+                    writeLoopExtension();
+                }
+            }
+        } else if (loopExtensionPending) {
+            writeLoopExtension();
+        }
+
+        if (fixed) {
+            fixedQuantizer->mapPixels(rgba, pixelCount, indices.data());
+        } else {
+            quantizer.mapPixels(rgba, pixelCount, indices.data());
+        }
+
+        // Graphic control extension
+        writeByte(0x21);
+        writeByte(0xF9);
+        writeByte(4);
+        writeByte(1 << 2);  // Disposal: leave in place, no transparency
+        writeShort(static_cast<uint16_t>(std::min(delayCentiseconds, 0xFFFF)));
+        writeByte(0);
+        writeByte(0);
+
+        // Image descriptor
+        writeByte(0x2C);
+        writeShort(static_cast<uint16_t>(region.left));
+        writeShort(static_cast<uint16_t>(region.top));
+        writeShort(static_cast<uint16_t>(region.width));
+        writeShort(static_cast<uint16_t>(region.height));
+        writeByte(writeLocalTable ? static_cast<uint8_t>(0x80 | (bits - 1)) : 0);
+        if (writeLocalTable) {
+            writeColorTable(colors, bits);
+        }
+
+        compress(indices.data(), pixelCount, std::max(2, bits));
+        frameCount++;
+        return static_cast<bool>(file);
+    }
+
+    void close() {
+        if (file.is_open()) {
+            writeByte(0x3B); // Trailer
+            file.close();
+        }
+    }
+
+    int getFrameCount() const {
+        return frameCount;
+    }
+
+private:
+    // NETSCAPE2.0 application extension; must follow the global color table
+    void writeLoopExtension() {
+        writeByte(0x21);
+        writeByte(0xFF);
+        writeByte(11);
+        file.write("NETSCAPE2.0", 11);
+        writeByte(3);
+        writeByte(1);
+        writeShort(static_cast<uint16_t>(loopCount));
+        writeByte(0);
+        loopExtensionPending = false;
+    }
+};
+
+#endif // GIF_ENCODER_HPP
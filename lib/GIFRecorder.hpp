@@ -2,51 +2,235 @@
 #define GIF_RECORDER_HPP
 
 #include <SFML/Graphics.hpp>
+#include <SFML/OpenGL.hpp>
 #include <vector>
 #include <string>
-#include <iomanip>
-#include <sstream>
 #include <iostream>
-#include <filesystem>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include "FrameQueue.hpp"
+#include "FrameSink.hpp"
+#include "FrameDiff.hpp"
+#include "LatencyStats.hpp"
+
+enum class RecordingFormat {
+    GIF,            // Streamed into animation.gif while recording
+    ImageSequence,  // frames/frame_XXXX.png (or .qoi, ...), encoded in parallel
+    Spool,          // Changed regions of raw frames in recording.spool, limited by disk space
+    Y4M             // Uncompressed YUV4MPEG2 video, to a file or stdout ("-")
+};
 
 class GIFRecorder {
 private:
-    std::vector<sf::Image> frames;
     bool isRecording;
     int maxFrames;
+    int frameLimit;
     int recordedFrames;
     float targetFPS;
     float frameInterval;
     float accumulatedTime;
     sf::RenderTexture renderTexture;
+    unsigned int canvasWidth;
+    unsigned int canvasHeight;
+    RecordingFormat format;
+    ImageFormat imageFormat;
+    std::string outputPath;
+    std::shared_ptr<const FixedPaletteQuantizer> fixedPalette;
+    std::unique_ptr<FrameSink> sink;
+
+    // Capture pipeline: the render thread reads pixels straight into pooled
+    // buffers, worker threads encode them while recording continues.
+    std::vector<sf::Uint8> flipRow;
+    FrameQueue queue;
+    std::vector<std::thread> workers;
+    unsigned int workerCount;
+    std::atomic<int> droppedFrames;
+    std::atomic<int> savedFrames;
+    std::atomic<int> failedFrames;
+    bool waitForEncoder;
+
+    // Delta stage: the newest distinct frame is held back until the next
+    // capture shows whether it changed, so identical captures can extend
+    // its duration instead of being encoded again
+    bool deltaDetection;
+    bool deltaActive;
+    CapturedFrame* heldFrame;
+    int emittedFrames;
+    int identicalFrames;
+
+    // Time captureFrame() holds up the render thread, per captured frame
+    LatencyStats captureLatency;
+
+    void emitFrame(CapturedFrame* frame) {
+        frame->index = emittedFrames++;
+        queue.push(frame);
+    }
+
+    void flushHeldFrame() {
+        if (heldFrame) {
+            emitFrame(heldFrame);
+            heldFrame = nullptr;
+        }
+    }
+
+    void startWorkers() {
+        queue.reopen();
+        unsigned int count = sink->isOrdered() ? 1 : workerCount;
+        for (unsigned int i = 0; i < count; ++i) {
+            workers.emplace_back(&GIFRecorder::encodeLoop, this);
+        }
+    }
+
+    void stopWorkers() {
+        queue.close();
+        for (auto& worker : workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        workers.clear();
+    }
+
+    void encodeLoop() {
+        while (CapturedFrame* frame = queue.pop()) {
+            if (sink->writeFrame(*frame)) {
+                savedFrames++;
+            } else {
+                failedFrames++;
+            }
+            queue.release(frame);
+        }
+    }
+
+    static const char* defaultPath(RecordingFormat value) {
+        switch (value) {
+            case RecordingFormat::ImageSequence:
+                return "frames";
+            case RecordingFormat::Spool:
+                return "recording.spool";
+            case RecordingFormat::Y4M:
+                return "recording.y4m";
+            case RecordingFormat::GIF:
+            default:
+                return "animation.gif";
+        }
+    }
+
+    std::string currentPath() const {
+        return outputPath.empty() ? defaultPath(format) : outputPath;
+    }
+
+    static std::unique_ptr<FrameSink> makeSink(RecordingFormat value, const std::string& path,
+                                               std::shared_ptr<const FixedPaletteQuantizer> palette = nullptr,
+                                               ImageFormat images = ImageFormat::PNG) {
+        switch (value) {
+            case RecordingFormat::ImageSequence:
+                return std::make_unique<ImageSequenceSink>(path, images);
+            case RecordingFormat::Spool:
+                return std::make_unique<SpoolSink>(path);
+            case RecordingFormat::Y4M:
+                return std::make_unique<Y4MSink>(path);
+            case RecordingFormat::GIF:
+            default:
+                if (palette) {
+                    return std::make_unique<GIFSink>(path, palette);
+                }
+                return std::make_unique<GIFSink>(path);
+        }
+    }
+
+    // Status messages go to stderr while the video itself is on stdout
+    std::ostream& log() const {
+        return currentPath() == "-" ? std::cerr : std::cout;
+    }
 
 public:
-    GIFRecorder(int width, int height, int maxFrames = 300, float fps = 30.0f) :
-        isRecording(false), maxFrames(maxFrames), recordedFrames(0),
-        targetFPS(fps), frameInterval(1.0f / fps), accumulatedTime(0.0f) {
+    // queueSize bounds the number of frames waiting for (or in) encoding;
+    // workers = 0 picks one less than the number of hardware threads.
+    GIFRecorder(int width, int height, int maxFrames = 300, float fps = 30.0f,
+                int queueSize = 16, unsigned int workers = 0) :
+        isRecording(false), maxFrames(maxFrames), frameLimit(maxFrames), recordedFrames(0),
+        targetFPS(fps), frameInterval(1.0f / fps), accumulatedTime(0.0f),
+        canvasWidth(width), canvasHeight(height), format(RecordingFormat::GIF), imageFormat(ImageFormat::PNG),
+        queue(std::max(queueSize, 2)), workerCount(workers), droppedFrames(0), savedFrames(0), failedFrames(0), waitForEncoder(false),
+        deltaDetection(true), deltaActive(false), heldFrame(nullptr), emittedFrames(0), identicalFrames(0) {
         renderTexture.create(width, height);
+
+        if (workerCount == 0) {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+    }
+
+    ~GIFRecorder() {
+        if (isRecording) {
+            stopRecording();
+        }
+        stopWorkers();
     }
 
     void startRecording() {
+        // Let a previous recording finish encoding before reusing the workers
+        stopWorkers();
+
         isRecording = true;
         recordedFrames = 0;
         accumulatedTime = 0.0f;
-        frames.clear();
-        std::cout << "Started recording at " << targetFPS << " FPS..." << std::endl;
+        droppedFrames = 0;
+        savedFrames = 0;
+        failedFrames = 0;
+        emittedFrames = 0;
+        identicalFrames = 0;
+        captureLatency.clear();
+        captureLatency.reserve(std::min(maxFrames, 1 << 16));
+
+        // Held frames cost RAM only in the in-memory formats; a spool is
+        // bounded by the free space on its filesystem instead
+        frameLimit = maxFrames;
+        if (format == RecordingFormat::Spool) {
+            uint64_t fit = FrameSpoolWriter::framesThatFit(currentPath(), canvasWidth, canvasHeight);
+            frameLimit = static_cast<int>(std::min<uint64_t>(fit, std::numeric_limits<int>::max()));
+            if (frameLimit == 0) {
+                std::cerr << "Not enough disk space to spool frames." << std::endl;
+                isRecording = false;
+                return;
+            }
+        }
+
+        sink = makeSink(format, currentPath(), fixedPalette, imageFormat);
+        if (!sink->begin(canvasWidth, canvasHeight, targetFPS)) {
+            isRecording = false;
+            sink.reset();
+            return;
+        }
+        deltaActive = deltaDetection && sink->acceptsDeltaFrames();
+        startWorkers();
+        log() << "Started recording to " << sink->describe() << " at " << targetFPS << " FPS with "
+                  << workers.size() << " encode workers..." << std::endl;
     }
 
     void stopRecording() {
         isRecording = false;
-        std::cout << "Stopped recording. Saving frames..." << std::endl;
-        saveFrames();
+        flushHeldFrame();
+        log() << "Stopped recording. Finishing " << queue.depth() << " queued frames..." << std::endl;
+        stopWorkers();
+        if (sink) {
+            sink->finish();
+            printSummary();
+            sink.reset();
+        }
     }
 
     bool isRecordingNow() const {
         return isRecording;
     }
 
-    void update(float deltaTime, const sf::RenderWindow& window) {
-        if (isRecording && recordedFrames < maxFrames) {
+    void update(float deltaTime, sf::RenderWindow& window) {
+        if (isRecording && recordedFrames < frameLimit) {
             accumulatedTime += deltaTime;
 
             if (accumulatedTime >= frameInterval) {
@@ -56,33 +240,197 @@ public:
         }
     }
 
-    void captureFrame(const sf::RenderWindow& window) {
-        sf::Texture texture;
-        texture.create(window.getSize().x, window.getSize().y);
-        texture.update(window);
-        frames.push_back(texture.copyToImage());
+    void captureFrame(sf::RenderWindow& window) {
+        auto start = LatencyStats::Clock::now();
+        // Drop the frame before paying for the readback if the encoders are behind
+        CapturedFrame* frame = acquireBuffer();
+        if (!frame) {
+            return;
+        }
+        window.setActive(true);
+        readPixels(frame, window.getSize());
+        submitFrame(frame, start);
+    }
+
+    void captureFrame(sf::RenderTexture& target) {
+        auto start = LatencyStats::Clock::now();
+        if (CapturedFrame* frame = acquireBuffer()) {
+            target.setActive(true);
+            readPixels(frame, target.getSize());
+            submitFrame(frame, start);
+        }
+    }
+
+private:
+    CapturedFrame* acquireBuffer() {
+        if (waitForEncoder) {
+            return queue.acquireWait();
+        }
+        CapturedFrame* frame = queue.acquire();
+        if (!frame) {
+            droppedFrames++;
+        }
+        return frame;
+    }
+
+    // Reads the active target's framebuffer into the frame's own buffer, with
+    // no intermediate texture or image. OpenGL returns the rows bottom-up.
+    void readPixels(CapturedFrame* frame, sf::Vector2u size) {
+        frame->width = size.x;
+        frame->height = size.y;
+        frame->dirty = sf::IntRect(0, 0, size.x, size.y);
+        frame->duration = 1;
+        frame->pixels.resize(static_cast<size_t>(size.x) * size.y * 4);
+        glReadPixels(0, 0, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y), GL_RGBA, GL_UNSIGNED_BYTE,
+                     frame->pixels.data());
+
+        const size_t stride = static_cast<size_t>(size.x) * 4;
+        flipRow.resize(stride);
+        for (unsigned int top = 0; top < size.y / 2; ++top) {
+            sf::Uint8* upper = frame->pixels.data() + top * stride;
+            sf::Uint8* lower = frame->pixels.data() + (size.y - 1 - top) * stride;
+            std::memcpy(flipRow.data(), upper, stride);
+            std::memcpy(upper, lower, stride);
+            std::memcpy(lower, flipRow.data(), stride);
+        }
+    }
+
+    void submitFrame(CapturedFrame* frame, LatencyStats::Clock::time_point start) {
         recordedFrames++;
 
-        if (recordedFrames >= maxFrames) {
+        if (!deltaActive) {
+            emitFrame(frame);
+        } else if (!heldFrame) {
+            heldFrame = frame;
+        } else if (heldFrame->width != frame->width || heldFrame->height != frame->height ||
+                   framediff::findDirtyRect(heldFrame->pixels.data(), frame->pixels.data(),
+                                            frame->width, frame->height, frame->dirty)) {
+            emitFrame(heldFrame);
+            heldFrame = frame;
+        } else {
+            heldFrame->duration++;
+            identicalFrames++;
+            queue.release(frame);
+        }
+        captureLatency.addSince(start);
+
+        if (recordedFrames >= frameLimit) {
             stopRecording();
         }
     }
 
-    void saveFrames() const {
-        std::filesystem::create_directory("frames");
-        for (int i = 0; i < frames.size(); i++) {
-            std::stringstream filename;
-            filename << "frames/frame_" << std::setw(4) << std::setfill('0') << i << ".png";
-            if (frames[i].saveToFile(filename.str())) {
-                std::cout << "Saved " << filename.str() << std::endl;
-            } else {
-                std::cerr << "Failed to save " << filename.str() << std::endl;
-            }
+public:
+
+    void printSummary() const {
+        std::ostream& out = log();
+        out << "Saved " << savedFrames << " frames to " << sink->describe();
+        if (failedFrames > 0) {
+            out << " (" << failedFrames << " failed)";
+        }
+        if (deltaActive) {
+            out << ", " << identicalFrames << " identical captures merged";
+        }
+        out << ". Dropped " << droppedFrames << " frames, peak queue depth "
+                  << queue.getPeakDepth() << "/" << queue.capacity() << "." << std::endl;
+        if (!captureLatency.empty()) {
+            out << "Capture latency p50 " << captureLatency.percentile(50) << " ms, p95 "
+                << captureLatency.percentile(95) << " ms, p99 " << captureLatency.percentile(99)
+                << " ms, max " << captureLatency.max() << " ms." << std::endl;
+        }
+    }
+
+    // Per-frame capture stall of the current (or last) recording
+    const LatencyStats& getCaptureLatency() const {
+        return captureLatency;
+    }
+
+    // Takes effect at the next startRecording()
+    void setFormat(RecordingFormat newFormat) {
+        format = newFormat;
+    }
+
+    // GIFs are quantized against this palette (plus the background and
+    // blends between all of them) instead of running median cut on the
+    // frames. The lookup is built here, once, not per recording.
+    void setPalette(const std::vector<sf::Color>& colors, sf::Color background = sf::Color::Black) {
+        auto quantizer = std::make_shared<FixedPaletteQuantizer>();
+        quantizer->setPalette(colors, background);
+        fixedPalette = quantizer;
+    }
+
+    // Back to median cut for arbitrary content
+    void clearPalette() {
+        fixedPalette.reset();
+    }
+
+    // File format of ImageSequence recordings
+    void setImageFormat(ImageFormat value) {
+        imageFormat = value;
+    }
+
+    ImageFormat getImageFormat() const {
+        return imageFormat;
+    }
+
+    // Overrides the file (or directory, for image sequences) written by the next
+    // recording; an empty path restores the format's default. "-" streams
+    // Y4M video to stdout, e.g. "./app | ffmpeg -i - out.mp4".
+    void setOutputPath(const std::string& path) {
+        outputPath = path;
+    }
+
+    const std::string& getOutputPath() const {
+        return outputPath;
+    }
+
+    // Skip identical frames and encode only changed regions where the
+    // output format supports it. Takes effect at the next startRecording().
+    void setDeltaDetection(bool enabled) {
+        deltaDetection = enabled;
+    }
+
+    int getIdenticalFrames() const {
+        return identicalFrames;
+    }
+
+    RecordingFormat getFormat() const {
+        return format;
+    }
+
+    static const char* formatName(RecordingFormat value) {
+        switch (value) {
+            case RecordingFormat::ImageSequence:
+                return "Images";
+            case RecordingFormat::Spool:
+                return "Spool";
+            case RecordingFormat::Y4M:
+                return "Y4M";
+            case RecordingFormat::GIF:
+            default:
+                return "GIF";
         }
-        std::cout << "Saved " << frames.size() << " frames to the 'frames' directory." << std::endl;
+    }
 
-        int delay = static_cast<int>(100.0f / targetFPS);
-        std::cout << "Command: convert -delay " << delay << " -loop 0 frames/frame_*.png animation.gif" << std::endl;
+    // Encodes a spool written by a previous recording into the given format
+    // ("-" as outputPath streams Y4M to stdout)
+    static int encodeSpool(const std::string& spoolPath, RecordingFormat target, const std::string& outputPath = "",
+                           ImageFormat images = ImageFormat::PNG) {
+        if (target == RecordingFormat::Spool) {
+            std::cerr << "Cannot encode a spool into another spool." << std::endl;
+            return 0;
+        }
+        std::string path = outputPath.empty() ? defaultPath(target) : outputPath;
+        std::unique_ptr<FrameSink> output = makeSink(target, path, nullptr, images);
+        int written = ::encodeSpool(spoolPath, *output);
+        (path == "-" ? std::cerr : std::cout) << "Encoded " << written << " spooled frames to " << output->describe() << std::endl;
+        return written;
+    }
+
+    // When set, capture blocks until an encode worker is free instead of
+    // dropping the frame. For offline rendering, where no frame may be lost
+    // and there is no interactive frame rate to protect.
+    void setWaitForEncoder(bool wait) {
+        waitForEncoder = wait;
     }
 
     void setFPS(float fps) {
@@ -99,7 +447,23 @@ public:
     }
 
     int getMaxFrames() const {
-        return maxFrames;
+        return frameLimit;
+    }
+
+    int getDroppedFrames() const {
+        return droppedFrames;
+    }
+
+    size_t getQueueDepth() const {
+        return queue.depth();
+    }
+
+    size_t getPeakQueueDepth() const {
+        return queue.getPeakDepth();
+    }
+
+    size_t getQueueCapacity() const {
+        return queue.capacity();
     }
 };
 
@@ -0,0 +1,373 @@
+#ifndef GRADIENT_SAMPLER_HPP
+#define GRADIENT_SAMPLER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// sRGB <-> OKLab conversion (Björn Ottosson's OKLab, 2020). Interpolating
+// in OKLab keeps gradients perceptually even and avoids the muddy
+// midpoints of sRGB blending.
+namespace oklab {
+
+    struct Lab {
+        float L, a, b;
+    };
+
+    // Scalar reference, using the C library's pow and cbrt
+
+    inline float srgbToLinear(float c) {
+        return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    inline float linearToSrgb(float c) {
+        return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+    }
+
+    inline Lab fromColor(const sf::Color& color) {
+        float r = srgbToLinear(color.r / 255.0f);
+        float g = srgbToLinear(color.g / 255.0f);
+        float b = srgbToLinear(color.b / 255.0f);
+
+        float l = std::cbrt(0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+        float m = std::cbrt(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+        float s = std::cbrt(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+
+        return {0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s,
+                1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s,
+                0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s};
+    }
+
+    inline sf::Uint8 toByte(float c) {
+        return static_cast<sf::Uint8>(std::min(std::max(c, 0.0f), 1.0f) * 255.0f + 0.5f);
+    }
+
+    inline sf::Color toColor(const Lab& lab, sf::Uint8 alpha = 255) {
+        float l = lab.L + 0.3963377774f * lab.a + 0.2158037573f * lab.b;
+        float m = lab.L - 0.1055613458f * lab.a - 0.0638541728f * lab.b;
+        float s = lab.L - 0.0894841775f * lab.a - 1.2914855480f * lab.b;
+        l = l * l * l;
+        m = m * m * m;
+        s = s * s * s;
+
+        float r = 4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s;
+        float g = -1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s;
+        float b = -0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s;
+        return sf::Color(toByte(linearToSrgb(std::min(std::max(r, 0.0f), 1.0f))),
+                         toByte(linearToSrgb(std::min(std::max(g, 0.0f), 1.0f))),
+                         toByte(linearToSrgb(std::min(std::max(b, 0.0f), 1.0f))), alpha);
+    }
+
+#if defined(__SSE2__)
+    // Four-wide approximations of the transcendental functions above. The
+    // polynomials are good to about 1e-5 relative error, far below the
+    // 1/255 step of the 8-bit output.
+    namespace simd {
+
+        inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+
+        inline __m128 floor(__m128 x) {
+            __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+            return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+        }
+
+        inline __m128 clamp01(__m128 x) {
+            return _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        }
+
+        // x > 0. Exponent from the float bits, log2 of the mantissa m in
+        // [1, 2) from the atanh series in f = (m - 1) / (m + 1)
+        inline __m128 log2(__m128 x) {
+            __m128i bits = _mm_castps_si128(x);
+            __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+            __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+                                                     _mm_set1_epi32(0x3F800000)));
+            const __m128 one = _mm_set1_ps(1.0f);
+            __m128 f = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+            __m128 f2 = _mm_mul_ps(f, f);
+            __m128 p = _mm_set1_ps(1.0f / 9.0f);
+            p = _mm_add_ps(_mm_mul_ps(p, f2), _mm_set1_ps(1.0f / 7.0f));
+            p = _mm_add_ps(_mm_mul_ps(p, f2), _mm_set1_ps(1.0f / 5.0f));
+            p = _mm_add_ps(_mm_mul_ps(p, f2), _mm_set1_ps(1.0f / 3.0f));
+            p = _mm_add_ps(_mm_mul_ps(p, f2), one);
+            // 2 / ln(2)
+            return _mm_add_ps(exponent, _mm_mul_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.8853900818f)));
+        }
+
+        // Integer part through the exponent bits, fraction by its Taylor series
+        inline __m128 exp2(__m128 x) {
+            x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(127.0f));
+            __m128 whole = floor(x);
+            __m128 f = _mm_mul_ps(_mm_sub_ps(x, whole), _mm_set1_ps(0.6931471806f));
+            __m128 p = _mm_set1_ps(1.0f / 720.0f);
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f / 120.0f));
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f / 24.0f));
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f / 6.0f));
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(0.5f));
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+            __m128i scale = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(whole), _mm_set1_epi32(127)), 23);
+            return _mm_mul_ps(p, _mm_castsi128_ps(scale));
+        }
+
+        // x > 0
+        inline __m128 pow(__m128 x, float y) {
+            return exp2(_mm_mul_ps(log2(x), _mm_set1_ps(y)));
+        }
+
+        // Exponent divided by three through the float bits, then three
+        // Newton steps; the sign is carried separately
+        inline __m128 cbrt(__m128 x) {
+            const __m128 signMask = _mm_set1_ps(-0.0f);
+            __m128 sign = _mm_and_ps(x, signMask);
+            __m128 a = _mm_andnot_ps(signMask, x);
+
+            // bits / 3 through float math is plenty for a starting guess
+            __m128 bits = _mm_cvtepi32_ps(_mm_castps_si128(a));
+            __m128i third = _mm_cvttps_epi32(_mm_mul_ps(bits, _mm_set1_ps(1.0f / 3.0f)));
+            __m128 y = _mm_castsi128_ps(_mm_add_epi32(third, _mm_set1_epi32(0x2A514067)));
+
+            const __m128 thirdOf = _mm_set1_ps(1.0f / 3.0f);
+            const __m128 tiny = _mm_set1_ps(1e-30f);
+            for (int i = 0; i < 3; ++i) {
+                __m128 y2 = _mm_max_ps(_mm_mul_ps(y, y), tiny);
+                y = _mm_mul_ps(_mm_add_ps(_mm_add_ps(y, y), _mm_div_ps(a, y2)), thirdOf);
+            }
+            return _mm_or_ps(y, sign);
+        }
+
+        inline __m128 srgbToLinear(__m128 c) {
+            __m128 low = _mm_mul_ps(c, _mm_set1_ps(1.0f / 12.92f));
+            __m128 high = pow(_mm_mul_ps(_mm_add_ps(c, _mm_set1_ps(0.055f)), _mm_set1_ps(1.0f / 1.055f)), 2.4f);
+            return select(_mm_cmple_ps(c, _mm_set1_ps(0.04045f)), low, high);
+        }
+
+        // c in [0, 1]
+        inline __m128 linearToSrgb(__m128 c) {
+            __m128 low = _mm_mul_ps(c, _mm_set1_ps(12.92f));
+            __m128 safe = _mm_max_ps(c, _mm_set1_ps(0.0031308f));
+            __m128 high = _mm_sub_ps(_mm_mul_ps(pow(safe, 1.0f / 2.4f), _mm_set1_ps(1.055f)), _mm_set1_ps(0.055f));
+            return select(_mm_cmple_ps(c, _mm_set1_ps(0.0031308f)), low, high);
+        }
+    }
+#endif
+
+    // Converts colors to OKLab, four at a time where SSE2 is available
+    inline void fromColors(const sf::Color* colors, size_t count, Lab* out) {
+        size_t i = 0;
+#if defined(__SSE2__)
+        for (; i + 4 <= count; i += 4) {
+            const sf::Color* c = colors + i;
+            const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+            __m128 r = simd::srgbToLinear(_mm_mul_ps(_mm_set_ps(c[3].r, c[2].r, c[1].r, c[0].r), scale));
+            __m128 g = simd::srgbToLinear(_mm_mul_ps(_mm_set_ps(c[3].g, c[2].g, c[1].g, c[0].g), scale));
+            __m128 b = simd::srgbToLinear(_mm_mul_ps(_mm_set_ps(c[3].b, c[2].b, c[1].b, c[0].b), scale));
+
+            auto mix = [](__m128 x, float cx, __m128 y, float cy, __m128 z, float cz) {
+                return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(cx)), _mm_mul_ps(y, _mm_set1_ps(cy))),
+                                  _mm_mul_ps(z, _mm_set1_ps(cz)));
+            };
+            __m128 l = simd::cbrt(mix(r, 0.4122214708f, g, 0.5363325363f, b, 0.0514459929f));
+            __m128 m = simd::cbrt(mix(r, 0.2119034982f, g, 0.6806995451f, b, 0.1073969566f));
+            __m128 s = simd::cbrt(mix(r, 0.0883024619f, g, 0.2817188376f, b, 0.6299787005f));
+
+            float L[4], A[4], B[4];
+            _mm_storeu_ps(L, mix(l, 0.2104542553f, m, 0.7936177850f, s, -0.0040720468f));
+            _mm_storeu_ps(A, mix(l, 1.9779984951f, m, -2.4285922050f, s, 0.4505937099f));
+            _mm_storeu_ps(B, mix(l, 0.0259040371f, m, 0.7827717662f, s, -0.8086757660f));
+            for (int k = 0; k < 4; ++k) {
+                out[i + k] = {L[k], A[k], B[k]};
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            out[i] = fromColor(colors[i]);
+        }
+    }
+}
+
+// Maps scalars in [0, 1] to colors along a palette, interpolating between
+// evenly spaced stops in OKLab. A cyclic gradient wraps t and blends the
+// last color back into the first, for values around a circle.
+//
+// The palette is converted once; sample() then evaluates a whole batch of
+// inputs four at a time.
+class GradientSampler {
+private:
+    // Per segment: start color and the step to the next stop (SoA)
+    std::vector<float> startL, startA, startB, startAlpha;
+    std::vector<float> deltaL, deltaA, deltaB, deltaAlpha;
+    std::vector<oklab::Lab> referenceStops;
+    std::vector<sf::Uint8> alphas;
+    int segments;
+    bool cyclic;
+
+    // Segment index and fraction for t, shared by both paths
+    void locate(float t, int& segment, float& frac) const {
+        if (cyclic) {
+            t -= std::floor(t);
+        } else {
+            t = std::min(std::max(t, 0.0f), 1.0f);
+        }
+        float position = t * segments;
+        segment = std::min(static_cast<int>(position), segments - 1);
+        frac = position - segment;
+    }
+
+#if defined(__SSE2__)
+    void sample4(const float* t, sf::Color* out) const {
+        // locate() for four inputs
+        __m128 u = _mm_loadu_ps(t);
+        if (cyclic) {
+            u = _mm_sub_ps(u, oklab::simd::floor(u));
+        } else {
+            u = oklab::simd::clamp01(u);
+        }
+        __m128 position = _mm_mul_ps(u, _mm_set1_ps(static_cast<float>(segments)));
+        __m128 whole = _mm_min_ps(oklab::simd::floor(position), _mm_set1_ps(static_cast<float>(segments - 1)));
+        __m128 f = _mm_sub_ps(position, whole);
+        int segment[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(segment), _mm_cvttps_epi32(whole));
+
+        auto gather = [&](const std::vector<float>& start, const std::vector<float>& delta) {
+            __m128 s = _mm_set_ps(start[segment[3]], start[segment[2]], start[segment[1]], start[segment[0]]);
+            __m128 d = _mm_set_ps(delta[segment[3]], delta[segment[2]], delta[segment[1]], delta[segment[0]]);
+            return _mm_add_ps(s, _mm_mul_ps(d, f));
+        };
+        __m128 L = gather(startL, deltaL);
+        __m128 A = gather(startA, deltaA);
+        __m128 B = gather(startB, deltaB);
+        __m128 alpha = gather(startAlpha, deltaAlpha);
+
+        auto mix = [](__m128 x, float cx, __m128 y, float cy, __m128 z, float cz) {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(cx)), _mm_mul_ps(y, _mm_set1_ps(cy))),
+                              _mm_mul_ps(z, _mm_set1_ps(cz)));
+        };
+        __m128 l = mix(L, 1.0f, A, 0.3963377774f, B, 0.2158037573f);
+        __m128 m = mix(L, 1.0f, A, -0.1055613458f, B, -0.0638541728f);
+        __m128 s = mix(L, 1.0f, A, -0.0894841775f, B, -1.2914855480f);
+        l = _mm_mul_ps(_mm_mul_ps(l, l), l);
+        m = _mm_mul_ps(_mm_mul_ps(m, m), m);
+        s = _mm_mul_ps(_mm_mul_ps(s, s), s);
+
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        auto toBytes = [&](__m128 linear) {
+            __m128 encoded = oklab::simd::clamp01(oklab::simd::linearToSrgb(oklab::simd::clamp01(linear)));
+            return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(encoded, scale), half));
+        };
+        __m128i r = toBytes(mix(l, 4.0767416621f, m, -3.3077115913f, s, 0.2309699292f));
+        __m128i g = toBytes(mix(l, -1.2684380046f, m, 2.6097574011f, s, -0.3413193965f));
+        __m128i b = toBytes(mix(l, -0.0041960863f, m, -0.7034186147f, s, 1.7076147010f));
+        __m128i a = _mm_cvttps_epi32(_mm_add_ps(alpha, half));
+
+        // sf::Color is four bytes in r, g, b, a order
+        __m128i packed = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)),
+                                      _mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+        std::memcpy(static_cast<void*>(out), &packed, sizeof(packed));
+    }
+#endif
+
+public:
+    GradientSampler() : segments(0), cyclic(false) {}
+
+    explicit GradientSampler(const std::vector<sf::Color>& colors, bool cyclic = false) : GradientSampler() {
+        setColors(colors, cyclic);
+    }
+
+    void setColors(const std::vector<sf::Color>& colors, bool wrap = false) {
+        static_assert(sizeof(sf::Color) == 4, "sf::Color is expected to be packed RGBA");
+        cyclic = wrap;
+        std::vector<sf::Color> stops = colors.empty() ? std::vector<sf::Color>{sf::Color::White} : colors;
+        if (cyclic || stops.size() == 1) {
+            stops.push_back(stops.front());
+        }
+        segments = static_cast<int>(stops.size()) - 1;
+
+        std::vector<oklab::Lab> lab(stops.size());
+        oklab::fromColors(stops.data(), stops.size(), lab.data());
+
+        startL.resize(segments);
+        startA.resize(segments);
+        startB.resize(segments);
+        startAlpha.resize(segments);
+        deltaL.resize(segments);
+        deltaA.resize(segments);
+        deltaB.resize(segments);
+        deltaAlpha.resize(segments);
+        for (int i = 0; i < segments; ++i) {
+            startL[i] = lab[i].L;
+            startA[i] = lab[i].a;
+            startB[i] = lab[i].b;
+            startAlpha[i] = stops[i].a;
+            deltaL[i] = lab[i + 1].L - lab[i].L;
+            deltaA[i] = lab[i + 1].a - lab[i].a;
+            deltaB[i] = lab[i + 1].b - lab[i].b;
+            deltaAlpha[i] = static_cast<float>(stops[i + 1].a) - stops[i].a;
+        }
+
+        referenceStops.resize(stops.size());
+        alphas.resize(stops.size());
+        for (size_t i = 0; i < stops.size(); ++i) {
+            referenceStops[i] = oklab::fromColor(stops[i]);
+            alphas[i] = stops[i].a;
+        }
+    }
+
+    bool isCyclic() const {
+        return cyclic;
+    }
+
+    // Colors for count inputs
+    void sample(const float* t, size_t count, sf::Color* out) const {
+        size_t i = 0;
+#if defined(__SSE2__)
+        for (; i + 4 <= count; i += 4) {
+            sample4(t + i, out + i);
+        }
+        if (i < count) {
+            // Pad the tail so every input goes through the same code
+            float padded[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            sf::Color colors[4];
+            std::copy(t + i, t + count, padded);
+            sample4(padded, colors);
+            std::copy(colors, colors + (count - i), out + i);
+        }
+#else
+        sampleReference(t, count, out);
+#endif
+    }
+
+    sf::Color sample(float t) const {
+        sf::Color color;
+        sample(&t, 1, &color);
+        return color;
+    }
+
+    // Same mapping with the scalar C library functions, to check the
+    // approximations against
+    void sampleReference(const float* t, size_t count, sf::Color* out) const {
+        for (size_t i = 0; i < count; ++i) {
+            int segment;
+            float frac;
+            locate(t[i], segment, frac);
+            const oklab::Lab& a = referenceStops[segment];
+            const oklab::Lab& b = referenceStops[segment + 1];
+            oklab::Lab lab = {a.L + (b.L - a.L) * frac, a.a + (b.a - a.a) * frac, a.b + (b.b - a.b) * frac};
+            float alpha = alphas[segment] + (static_cast<float>(alphas[segment + 1]) - alphas[segment]) * frac;
+            out[i] = oklab::toColor(lab, static_cast<sf::Uint8>(alpha + 0.5f));
+        }
+    }
+};
+
+#endif // GRADIENT_SAMPLER_HPP
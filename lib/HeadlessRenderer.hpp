@@ -0,0 +1,139 @@
+#ifndef HEADLESS_RENDERER_HPP
+#define HEADLESS_RENDERER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <chrono>
+#include "GIFRecorder.hpp"
+
+// Command line switches shared by the sketches:
+//
+//   --headless N      render N frames offscreen and exit (no window)
+//   --fps F           simulated frames per second (default 60)
+//   --format NAME     gif, spool, y4m, or an image format for one file per
+//                     frame: png, qoi, pam or ppm (default gif)
+//   --output PATH     output file or directory; "-" streams y4m to stdout
+//   --palette NAME    palette to use instead of asking on the terminal
+//   --seed S          seed for every random choice the sketch makes
+//   --image-format F  png, qoi, pam or ppm for snapshots (default png)
+struct HeadlessOptions {
+    bool enabled = false;
+    int frames = 0;
+    float fps = 60.0f;
+    RecordingFormat format = RecordingFormat::GIF;
+    ImageFormat imageFormat = ImageFormat::PNG;
+    std::string outputPath;
+    std::string palette;
+    unsigned int seed = 1;
+
+    // Value following 'name' on the command line, or 'fallback'
+    static std::string argument(int argc, char* argv[], const char* name, const std::string& fallback = "") {
+        for (int i = 1; i + 1 < argc; ++i) {
+            if (std::strcmp(argv[i], name) == 0) {
+                return argv[i + 1];
+            }
+        }
+        return fallback;
+    }
+
+    static HeadlessOptions parse(int argc, char* argv[]) {
+        HeadlessOptions options;
+        std::string frames = argument(argc, argv, "--headless");
+        options.enabled = !frames.empty();
+        options.frames = std::max(0, std::atoi(frames.c_str()));
+        options.fps = std::max(1.0f, static_cast<float>(std::atof(argument(argc, argv, "--fps", "60").c_str())));
+        options.outputPath = argument(argc, argv, "--output");
+        options.palette = argument(argc, argv, "--palette");
+        options.seed = static_cast<unsigned int>(std::strtoul(argument(argc, argv, "--seed", "1").c_str(), nullptr, 10));
+
+        std::string images = argument(argc, argv, "--image-format", "png");
+        if (!ImageWriter::parseFormat(images, options.imageFormat)) {
+            std::cerr << "Unknown image format '" << images << "', using PNG." << std::endl;
+        }
+
+        std::string format = argument(argc, argv, "--format", "gif");
+        if (ImageWriter::parseFormat(format, options.imageFormat)) {
+            options.format = RecordingFormat::ImageSequence;
+        } else if (format == "spool") {
+            options.format = RecordingFormat::Spool;
+        } else if (format == "y4m") {
+            options.format = RecordingFormat::Y4M;
+        } else if (format != "gif") {
+            std::cerr << "Unknown format '" << format << "', recording a GIF." << std::endl;
+        }
+        return options;
+    }
+
+    // Messages must stay off stdout while video is streamed there
+    std::ostream& log() const {
+        return outputPath == "-" ? std::cerr : std::cout;
+    }
+};
+
+// Renders a sketch offscreen with a fixed timestep and records every frame.
+// There is no window, vsync or frame limit: frames are produced as fast as
+// the CPU allows, and the output depends only on the options, never on
+// wall-clock time.
+class HeadlessRenderer {
+private:
+    HeadlessOptions options;
+    sf::RenderTexture target;
+    GIFRecorder recorder;
+
+public:
+    HeadlessRenderer(unsigned int width, unsigned int height, const HeadlessOptions& opts)
+        : options(opts), recorder(width, height, std::max(1, opts.frames), opts.fps) {
+        target.create(width, height);
+        recorder.setFormat(options.format);
+        recorder.setImageFormat(options.imageFormat);
+        recorder.setOutputPath(options.outputPath);
+        recorder.setWaitForEncoder(true);
+    }
+
+    // For sketch-specific recorder settings such as setPalette()
+    GIFRecorder& getRecorder() {
+        return recorder;
+    }
+
+    sf::RenderTarget& getTarget() {
+        return target;
+    }
+
+    float getTimestep() const {
+        return 1.0f / options.fps;
+    }
+
+    // Calls step(dt) then draw(target) once per frame. Returns the number
+    // of frames captured.
+    template <typename Step, typename Draw>
+    int run(Step step, Draw draw) {
+        recorder.startRecording();
+        if (!recorder.isRecordingNow()) {
+            return 0;
+        }
+
+        const float dt = getTimestep();
+        auto start = std::chrono::steady_clock::now();
+        int rendered = 0;
+        for (; rendered < options.frames && recorder.isRecordingNow(); ++rendered) {
+            step(dt);
+            draw(static_cast<sf::RenderTarget&>(target));
+            target.display();
+            recorder.captureFrame(target);
+        }
+        if (recorder.isRecordingNow()) {
+            recorder.stopRecording();
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        options.log() << "Rendered " << rendered << " frames (" << rendered * dt << " s at " << options.fps
+                      << " FPS) in " << seconds << " s, " << (seconds > 0.0 ? rendered / seconds : 0.0)
+                      << " frames/s." << std::endl;
+        return rendered;
+    }
+};
+
+#endif // HEADLESS_RENDERER_HPP
@@ -0,0 +1,234 @@
+#ifndef IMAGE_WRITER_HPP
+#define IMAGE_WRITER_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+enum class ImageFormat {
+    PNG,    // Compressed, slow to write
+    QOI,    // Lossless, usually a few times smaller than raw and much faster than PNG
+    PAM,    // Raw RGBA with a text header (Netpbm P7)
+    PPM     // Raw RGB, alpha dropped (Netpbm P6)
+};
+
+// Writes still images in one of several formats. Snapshots and image
+// sequence recordings go through this, so the format is a runtime choice.
+class ImageWriter {
+public:
+    virtual ~ImageWriter() {}
+
+    virtual bool write(const std::string& path, const uint8_t* rgba, unsigned int width, unsigned int height) const = 0;
+
+    // Including the dot, e.g. ".qoi"
+    virtual const char* extension() const = 0;
+
+    bool write(const std::string& path, const sf::Image& image) const {
+        return write(path, image.getPixelsPtr(), image.getSize().x, image.getSize().y);
+    }
+
+    static std::unique_ptr<ImageWriter> create(ImageFormat format);
+
+    static const char* formatName(ImageFormat format) {
+        switch (format) {
+            case ImageFormat::QOI:
+                return "QOI";
+            case ImageFormat::PAM:
+                return "PAM";
+            case ImageFormat::PPM:
+                return "PPM";
+            case ImageFormat::PNG:
+            default:
+                return "PNG";
+        }
+    }
+
+    // Accepts the lower-case extension without the dot; false if unknown
+    static bool parseFormat(const std::string& name, ImageFormat& format) {
+        for (ImageFormat candidate : {ImageFormat::PNG, ImageFormat::QOI, ImageFormat::PAM, ImageFormat::PPM}) {
+            std::string extension = create(candidate)->extension();
+            if (name == extension.substr(1)) {
+                format = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+protected:
+    static bool writeFile(const std::string& path, const void* header, size_t headerSize,
+                          const void* data, size_t dataSize) {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        bool ok = std::fwrite(header, 1, headerSize, file) == headerSize &&
+                  std::fwrite(data, 1, dataSize, file) == dataSize;
+        return std::fclose(file) == 0 && ok;
+    }
+};
+
+class PNGImageWriter : public ImageWriter {
+public:
+    bool write(const std::string& path, const uint8_t* rgba, unsigned int width, unsigned int height) const override {
+        sf::Image image;
+        image.create(width, height, rgba);
+        return image.saveToFile(path);
+    }
+
+    const char* extension() const override {
+        return ".png";
+    }
+};
+
+// "Quite OK Image" format (qoiformat.org), RGBA, sRGB
+class QOIImageWriter : public ImageWriter {
+private:
+    static constexpr uint8_t OP_INDEX = 0x00;
+    static constexpr uint8_t OP_DIFF = 0x40;
+    static constexpr uint8_t OP_LUMA = 0x80;
+    static constexpr uint8_t OP_RUN = 0xC0;
+    static constexpr uint8_t OP_RGB = 0xFE;
+    static constexpr uint8_t OP_RGBA = 0xFF;
+
+    static uint8_t* putBigEndian(uint8_t* out, uint32_t value) {
+        out[0] = static_cast<uint8_t>(value >> 24);
+        out[1] = static_cast<uint8_t>(value >> 16);
+        out[2] = static_cast<uint8_t>(value >> 8);
+        out[3] = static_cast<uint8_t>(value);
+        return out + 4;
+    }
+
+public:
+    // Encodes into 'out' (replacing its contents); exposed for benchmarks
+    static void encode(const uint8_t* rgba, unsigned int width, unsigned int height, std::vector<uint8_t>& out) {
+        // Sized for the worst case (every pixel an RGBA op) and trimmed at the end
+        size_t pixelCount = static_cast<size_t>(width) * height;
+        out.resize(14 + pixelCount * 5 + 8);
+        uint8_t* p = out.data();
+        *p++ = 'q';
+        *p++ = 'o';
+        *p++ = 'i';
+        *p++ = 'f';
+        p = putBigEndian(p, width);
+        p = putBigEndian(p, height);
+        *p++ = 4;   // Channels
+        *p++ = 0;   // sRGB with linear alpha
+
+        uint32_t index[64] = {};
+        uint8_t previous[4] = {0, 0, 0, 255};
+        int run = 0;
+
+        for (size_t i = 0; i < pixelCount; ++i) {
+            const uint8_t* px = rgba + i * 4;
+            if (std::memcmp(px, previous, 4) == 0) {
+                run++;
+                if (run == 62 || i + 1 == pixelCount) {
+                    *p++ = static_cast<uint8_t>(OP_RUN | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *p++ = static_cast<uint8_t>(OP_RUN | (run - 1));
+                run = 0;
+            }
+
+            uint32_t value;
+            std::memcpy(&value, px, 4);
+            int slot = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+            if (index[slot] == value) {
+                *p++ = static_cast<uint8_t>(OP_INDEX | slot);
+            } else {
+                index[slot] = value;
+                if (px[3] == previous[3]) {
+                    int8_t dr = static_cast<int8_t>(px[0] - previous[0]);
+                    int8_t dg = static_cast<int8_t>(px[1] - previous[1]);
+                    int8_t db = static_cast<int8_t>(px[2] - previous[2]);
+                    int drg = dr - dg;
+                    int dbg = db - dg;
+                    if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                        *p++ = static_cast<uint8_t>(OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                    } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                        *p++ = static_cast<uint8_t>(OP_LUMA | (dg + 32));
+                        *p++ = static_cast<uint8_t>((drg + 8) << 4 | (dbg + 8));
+                    } else {
+                        *p++ = OP_RGB;
+                        std::memcpy(p, px, 3);
+                        p += 3;
+                    }
+                } else {
+                    *p++ = OP_RGBA;
+                    std::memcpy(p, px, 4);
+                    p += 4;
+                }
+            }
+            std::memcpy(previous, px, 4);
+        }
+        static const uint8_t padding[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+        std::memcpy(p, padding, sizeof(padding));
+        out.resize(p + sizeof(padding) - out.data());
+    }
+
+    bool write(const std::string& path, const uint8_t* rgba, unsigned int width, unsigned int height) const override {
+        // One buffer per thread: sequence sinks call this from several workers
+        thread_local std::vector<uint8_t> buffer;
+        encode(rgba, width, height, buffer);
+        return writeFile(path, buffer.data(), 0, buffer.data(), buffer.size());
+    }
+
+    const char* extension() const override {
+        return ".qoi";
+    }
+};
+
+class PAMImageWriter : public ImageWriter {
+public:
+    bool write(const std::string& path, const uint8_t* rgba, unsigned int width, unsigned int height) const override {
+        std::string header = "P7\nWIDTH " + std::to_string(width) + "\nHEIGHT " + std::to_string(height) +
+                             "\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n";
+        return writeFile(path, header.data(), header.size(), rgba, static_cast<size_t>(width) * height * 4);
+    }
+
+    const char* extension() const override {
+        return ".pam";
+    }
+};
+
+class PPMImageWriter : public ImageWriter {
+public:
+    bool write(const std::string& path, const uint8_t* rgba, unsigned int width, unsigned int height) const override {
+        size_t pixelCount = static_cast<size_t>(width) * height;
+        thread_local std::vector<uint8_t> rgb;
+        rgb.resize(pixelCount * 3);
+        for (size_t i = 0; i < pixelCount; ++i) {
+            std::memcpy(&rgb[i * 3], rgba + i * 4, 3);
+        }
+        std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+        return writeFile(path, header.data(), header.size(), rgb.data(), rgb.size());
+    }
+
+    const char* extension() const override {
+        return ".ppm";
+    }
+};
+
+inline std::unique_ptr<ImageWriter> ImageWriter::create(ImageFormat format) {
+    switch (format) {
+        case ImageFormat::QOI:
+            return std::make_unique<QOIImageWriter>();
+        case ImageFormat::PAM:
+            return std::make_unique<PAMImageWriter>();
+        case ImageFormat::PPM:
+            return std::make_unique<PPMImageWriter>();
+        case ImageFormat::PNG:
+        default:
+            return std::make_unique<PNGImageWriter>();
+    }
+}
+
+#endif // IMAGE_WRITER_HPP
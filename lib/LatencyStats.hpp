@@ -0,0 +1,86 @@
+#ifndef LATENCY_STATS_HPP
+#define LATENCY_STATS_HPP
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstddef>
+#include <cmath>
+
+// Collects per-event durations (in milliseconds) and reports percentiles.
+// Samples are kept individually: a recording holds at most a few thousand
+// of them, and sorting once at report time is cheaper than a histogram
+// that needs a guessed range.
+class LatencyStats {
+private:
+    std::vector<double> samples;
+    mutable std::vector<double> sorted;
+    mutable bool sortedValid = false;
+
+    const std::vector<double>& sortedSamples() const {
+        if (!sortedValid) {
+            sorted = samples;
+            std::sort(sorted.begin(), sorted.end());
+            sortedValid = true;
+        }
+        return sorted;
+    }
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void reserve(size_t count) {
+        samples.reserve(count);
+    }
+
+    void clear() {
+        samples.clear();
+        sortedValid = false;
+    }
+
+    void add(double milliseconds) {
+        samples.push_back(milliseconds);
+        sortedValid = false;
+    }
+
+    // Adds the time elapsed since 'start'
+    void addSince(Clock::time_point start) {
+        add(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+
+    size_t count() const {
+        return samples.size();
+    }
+
+    bool empty() const {
+        return samples.empty();
+    }
+
+    // Nearest-rank percentile, p in [0, 100]; 0 when there are no samples
+    double percentile(double p) const {
+        const std::vector<double>& values = sortedSamples();
+        if (values.empty()) {
+            return 0.0;
+        }
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+        rank = std::min(std::max<size_t>(rank, 1), values.size());
+        return values[rank - 1];
+    }
+
+    double max() const {
+        return samples.empty() ? 0.0 : *std::max_element(samples.begin(), samples.end());
+    }
+
+    double mean() const {
+        if (samples.empty()) {
+            return 0.0;
+        }
+        double total = 0.0;
+        for (double value : samples) {
+            total += value;
+        }
+        return total / samples.size();
+    }
+};
+
+#endif // LATENCY_STATS_HPP
@@ -0,0 +1,43 @@
+#ifndef PALETTE_MENU_HPP
+#define PALETTE_MENU_HPP
+
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <string>
+#include <limits>
+#include "Palettes.hpp"
+
+// Print a color block to the terminal
+inline void printColorBlock(const sf::Color& color) {
+    std::cout << "\033[48;2;" << (int)color.r << ";" << (int)color.g << ";" << (int)color.b << "m    \033[0m";
+}
+
+// Lists the palettes with color swatches and asks for one on the terminal.
+// Consumes the rest of the input line, so std::getline can follow.
+inline std::string choosePalette() {
+    std::cout << "Available palettes:\n";
+    for (int i = 0; i < PALETTE_COUNT; ++i) {
+        PaletteId id = static_cast<PaletteId>(i);
+        std::cout << i + 1 << ". " << paletteName(id) << ": ";
+        for (const auto& color : getPalette(id)) {
+            printColorBlock(color);
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "Enter the number of your desired palette: ";
+    int choice = 0;
+    std::cin >> choice;
+
+    // Clear the input buffer in case of bad input
+    std::cin.clear();
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+    if (choice >= 1 && choice <= PALETTE_COUNT) {
+        return paletteName(static_cast<PaletteId>(choice - 1));
+    }
+    std::cerr << "Invalid choice. Using default palette 'vibrant'." << std::endl;
+    return "vibrant";
+}
+
+#endif // PALETTE_MENU_HPP
@@ -2,64 +2,212 @@
 #define PALETTES_HPP
 
 #include <SFML/Graphics.hpp>
-#include <map>
+#include <array>
 #include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
 #include <iostream>
 
-const std::vector<sf::Color>& getPalette(const std::string& name) {
-    static const std::map<std::string, std::vector<sf::Color>> palettes = {
-        {"vibrant", {
-            sf::Color(255, 102, 102),   // Red
-            sf::Color(255, 255, 102),   // Yellow
-            sf::Color(102, 255, 102),   // Light Green
-            sf::Color(102, 102, 255),   // Blue
-            sf::Color(255, 102, 255)    // Magenta
-        }},
-        {"pastel", {
-            sf::Color(207, 216, 220),   // Blue Gray
-            sf::Color(225, 190, 231),   // Lavender
-            sf::Color(255, 243, 224),   // Off White
-            sf::Color(178, 223, 219),   // Light Cyan
-            sf::Color(255, 236, 179)    // Yellow
-        }},
-        {"earthy", {
-            sf::Color(139, 69, 19),
-            sf::Color(205, 133, 63),
-            sf::Color(160, 82, 45),
-            sf::Color(245, 245, 220),
-            sf::Color(188, 143, 143)
-        }},
-        {"neon", {
-            sf::Color(255, 20, 147),
-            sf::Color(0, 255, 255),
-            sf::Color(50, 255, 50),
-            sf::Color(255, 0, 255),
-            sf::Color(255, 215, 0)
-        }},
-        {"monochrome", {
-            sf::Color(20, 20, 20),
-            sf::Color(80, 80, 80),
-            sf::Color(140, 140, 140),
-            sf::Color(200, 200, 200),
-            sf::Color(240, 240, 240)
-        }},
-        {"default", {
-            sf::Color(117, 131, 158),
-            sf::Color(219, 142, 60),
-            sf::Color(255, 222, 173),
-            sf::Color(107, 185, 240),
-            sf::Color(189, 195, 199),
-            sf::Color(102, 205, 170)
-        }}
+// The project palettes, addressed by ID. The tables are constexpr so they
+// cost nothing at startup; sf::Color has no constexpr constructor in SFML
+// 2.5, hence the plain RGB struct.
+enum class PaletteId {
+    Vibrant,
+    Pastel,
+    Earthy,
+    Neon,
+    Monochrome,
+    Default
+};
+
+inline constexpr int PALETTE_COUNT = 6;
+
+// Entries in a palette's gradient lookup table
+inline constexpr int GRADIENT_SIZE = 256;
+
+struct PaletteColor {
+    uint8_t r, g, b;
+};
+
+namespace palettes {
+
+    inline constexpr PaletteColor vibrant[] = {
+        {255, 102, 102},    // Red
+        {255, 255, 102},    // Yellow
+        {102, 255, 102},    // Light Green
+        {102, 102, 255},    // Blue
+        {255, 102, 255}     // Magenta
+    };
+
+    inline constexpr PaletteColor pastel[] = {
+        {207, 216, 220},    // Blue Gray
+        {225, 190, 231},    // Lavender
+        {255, 243, 224},    // Off White
+        {178, 223, 219},    // Light Cyan
+        {255, 236, 179}     // Yellow
+    };
+
+    inline constexpr PaletteColor earthy[] = {
+        {139, 69, 19},
+        {205, 133, 63},
+        {160, 82, 45},
+        {245, 245, 220},
+        {188, 143, 143}
+    };
+
+    inline constexpr PaletteColor neon[] = {
+        {255, 20, 147},
+        {0, 255, 255},
+        {50, 255, 50},
+        {255, 0, 255},
+        {255, 215, 0}
+    };
+
+    inline constexpr PaletteColor monochrome[] = {
+        {20, 20, 20},
+        {80, 80, 80},
+        {140, 140, 140},
+        {200, 200, 200},
+        {240, 240, 240}
+    };
+
+    inline constexpr PaletteColor defaults[] = {
+        {117, 131, 158},
+        {219, 142, 60},
+        {255, 222, 173},
+        {107, 185, 240},
+        {189, 195, 199},
+        {102, 205, 170}
+    };
+
+    struct Entry {
+        const char* name;
+        const PaletteColor* colors;
+        int size;
+    };
+
+    // Indexed by PaletteId
+    inline constexpr Entry table[PALETTE_COUNT] = {
+        {"vibrant", vibrant, std::size(vibrant)},
+        {"pastel", pastel, std::size(pastel)},
+        {"earthy", earthy, std::size(earthy)},
+        {"neon", neon, std::size(neon)},
+        {"monochrome", monochrome, std::size(monochrome)},
+        {"default", defaults, std::size(defaults)}
+    };
+
+    // Evenly spaced stops, linearly interpolated in sRGB with integer
+    // rounding so the table is the same on every compiler
+    constexpr std::array<PaletteColor, GRADIENT_SIZE> makeGradient(const Entry& entry) {
+        std::array<PaletteColor, GRADIENT_SIZE> lut{};
+        const int last = GRADIENT_SIZE - 1;
+        for (int i = 0; i < GRADIENT_SIZE; ++i) {
+            if (entry.size == 1) {
+                lut[i] = entry.colors[0];
+                continue;
+            }
+            int position = i * (entry.size - 1);
+            int segment = position / last;
+            int frac = position % last;
+            if (segment == entry.size - 1) {
+                segment--;
+                frac = last;
+            }
+            const PaletteColor& a = entry.colors[segment];
+            const PaletteColor& b = entry.colors[segment + 1];
+            lut[i] = {static_cast<uint8_t>((a.r * (last - frac) + b.r * frac + last / 2) / last),
+                      static_cast<uint8_t>((a.g * (last - frac) + b.g * frac + last / 2) / last),
+                      static_cast<uint8_t>((a.b * (last - frac) + b.b * frac + last / 2) / last)};
+        }
+        return lut;
+    }
+
+    inline constexpr std::array<PaletteColor, GRADIENT_SIZE> gradients[PALETTE_COUNT] = {
+        makeGradient(table[0]),
+        makeGradient(table[1]),
+        makeGradient(table[2]),
+        makeGradient(table[3]),
+        makeGradient(table[4]),
+        makeGradient(table[5])
     };
+}
+
+constexpr const char* paletteName(PaletteId id) {
+    return palettes::table[static_cast<int>(id)].name;
+}
+
+constexpr int paletteSize(PaletteId id) {
+    return palettes::table[static_cast<int>(id)].size;
+}
+
+constexpr PaletteColor paletteColor(PaletteId id, int index) {
+    return palettes::table[static_cast<int>(id)].colors[index];
+}
+
+inline sf::Color toColor(const PaletteColor& color, sf::Uint8 alpha = 255) {
+    return sf::Color(color.r, color.g, color.b, alpha);
+}
 
-    auto it = palettes.find(name);
-    if (it != palettes.end()) {
-        return it->second;
+// Looks a palette up by name; false (and 'id' unchanged) if there is none
+inline bool findPalette(const std::string& name, PaletteId& id) {
+    for (int i = 0; i < PALETTE_COUNT; ++i) {
+        if (name == palettes::table[i].name) {
+            id = static_cast<PaletteId>(i);
+            return true;
+        }
     }
+    return false;
+}
+
+// The palette as sf::Colors, converted once per program
+inline const std::vector<sf::Color>& getPalette(PaletteId id) {
+    static const std::array<std::vector<sf::Color>, PALETTE_COUNT> converted = [] {
+        std::array<std::vector<sf::Color>, PALETTE_COUNT> result;
+        for (int i = 0; i < PALETTE_COUNT; ++i) {
+            for (int j = 0; j < palettes::table[i].size; ++j) {
+                result[i].push_back(toColor(palettes::table[i].colors[j]));
+            }
+        }
+        return result;
+    }();
+    return converted[static_cast<int>(id)];
+}
+
+// The gradient table as GRADIENT_SIZE sf::Colors, from the first palette
+// color at index 0 to the last at GRADIENT_SIZE - 1
+inline const sf::Color* getGradient(PaletteId id) {
+    static const std::array<std::array<sf::Color, GRADIENT_SIZE>, PALETTE_COUNT> converted = [] {
+        std::array<std::array<sf::Color, GRADIENT_SIZE>, PALETTE_COUNT> result;
+        for (int i = 0; i < PALETTE_COUNT; ++i) {
+            for (int j = 0; j < GRADIENT_SIZE; ++j) {
+                result[i][j] = toColor(palettes::gradients[i][j]);
+            }
+        }
+        return result;
+    }();
+    return converted[static_cast<int>(id)].data();
+}
+
+// Color at t in [0, 1] along the palette gradient (clamped)
+inline sf::Color sampleGradient(const sf::Color* gradient, float t) {
+    int index = static_cast<int>(t * (GRADIENT_SIZE - 1) + 0.5f);
+    index = index < 0 ? 0 : (index > GRADIENT_SIZE - 1 ? GRADIENT_SIZE - 1 : index);
+    return gradient[index];
+}
+
+// Name-based lookup kept for the terminal menus and --palette
+inline PaletteId getPaletteId(const std::string& name) {
+    PaletteId id = PaletteId::Default;
+    if (!findPalette(name, id)) {
+        std::cerr << "Warning: Palette '" << name << "' not found. Using default." << std::endl;
+    }
+    return id;
+}
 
-    std::cerr << "Warning: Palette '" << name << "' not found. Using default." << std::endl;
-    return palettes.at("default");
+inline const std::vector<sf::Color>& getPalette(const std::string& name) {
+    return getPalette(getPaletteId(name));
 }
 
 #endif // PALETTES_HPP
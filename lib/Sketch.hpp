@@ -0,0 +1,216 @@
+#ifndef SKETCH_HPP
+#define SKETCH_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <string>
+#include <memory>
+#include <map>
+#include <random>
+#include <functional>
+#include <iostream>
+#include "Palettes.hpp"
+#include "PaletteMenu.hpp"
+#include "GIFRecorder.hpp"
+#include "HeadlessRenderer.hpp"
+#include "ImageWriter.hpp"
+
+// What a sketch sees of the user each frame. Headless renders have no
+// mouse: sketches that follow it drive themselves instead.
+struct SketchInput {
+    sf::Vector2f mouse;
+    bool hasMouse = false;
+    bool mousePressed = false;
+};
+
+// One piece of generative art. The host (SketchHost) owns the window, the
+// common keys (R, S, G, F, Q), the overlay and recording; a sketch only
+// simulates and draws.
+class Sketch {
+public:
+    virtual ~Sketch() {}
+
+    virtual sf::Vector2u getSize() const = 0;
+
+    // R key
+    virtual void reset() = 0;
+
+    virtual void update(float deltaTime, const SketchInput& input) = 0;
+
+    // Draws the whole frame, background included
+    virtual void draw(sf::RenderTarget& target) = 0;
+
+    // Sketch-specific input; return true if the event was used
+    virtual bool handleEvent(const sf::Event&) {
+        return false;
+    }
+
+    // Extra keys for the overlay, e.g. "Space: Blow off"
+    virtual std::string getHelp() const {
+        return "";
+    }
+
+    // A line of live information for the overlay
+    virtual std::string getStatus() const {
+        return "";
+    }
+
+    virtual sf::Vector2f getOverlayPosition() const {
+        return sf::Vector2f(10.0f, 10.0f);
+    }
+
+    // Colors the sketch draws with, for the fixed-palette GIF quantizer;
+    // empty if the output is arbitrary
+    virtual std::vector<sf::Color> getRecordingColors() const {
+        return {};
+    }
+
+    virtual float getRecordingFPS() const {
+        return 30.0f;
+    }
+
+    virtual unsigned int getFrameRateLimit() const {
+        return 60;
+    }
+};
+
+// State shared by every sketch in a process, created on first use: the
+// palette (asked on the terminal only if a sketch needs one and --palette
+// was not given), fonts, the image writer and one recorder per canvas size.
+class SketchResources {
+private:
+    int argc;
+    char** argv;
+    HeadlessOptions options;
+    std::string paletteName;
+    bool promptsAllowed;
+    std::map<std::string, std::unique_ptr<sf::Font>> fonts;
+    std::unique_ptr<ImageWriter> imageWriter;
+    std::map<std::pair<unsigned int, unsigned int>, std::unique_ptr<GIFRecorder>> recorders;
+    std::random_device randomDevice;
+
+public:
+    SketchResources(int argc, char* argv[])
+        : argc(argc), argv(argv), options(HeadlessOptions::parse(argc, argv)), paletteName(options.palette),
+          promptsAllowed(true) {}
+
+    const HeadlessOptions& getOptions() const {
+        return options;
+    }
+
+    bool isHeadless() const {
+        return options.enabled;
+    }
+
+    // Sketch-specific command line value, e.g. --text
+    std::string argument(const char* name, const std::string& fallback = "") const {
+        return HeadlessOptions::argument(argc, argv, name, fallback);
+    }
+
+    // Terminal questions are only asked before the window opens; a sketch
+    // created later takes its defaults instead
+    bool canPrompt() const {
+        return promptsAllowed;
+    }
+
+    void setPromptsAllowed(bool allowed) {
+        promptsAllowed = allowed;
+    }
+
+    const std::string& getPaletteName() {
+        if (paletteName.empty()) {
+            if (promptsAllowed) {
+                paletteName = choosePalette();
+            } else {
+                paletteName = "vibrant";
+                std::cerr << "No --palette given. Using palette 'vibrant'." << std::endl;
+            }
+        }
+        return paletteName;
+    }
+
+    // Loads fonts/<file> once; nullptr (with one warning) if it is missing
+    const sf::Font* getFont(const std::string& file) {
+        auto it = fonts.find(file);
+        if (it == fonts.end()) {
+            auto font = std::make_unique<sf::Font>();
+            if (!font->loadFromFile("fonts/" + file)) {
+                std::cerr << "Warning: Could not load font fonts/" << file << "." << std::endl;
+                font.reset();
+            }
+            it = fonts.emplace(file, std::move(font)).first;
+        }
+        return it->second.get();
+    }
+
+    const ImageWriter& getImageWriter() {
+        if (!imageWriter) {
+            imageWriter = ImageWriter::create(options.imageFormat);
+        }
+        return *imageWriter;
+    }
+
+    GIFRecorder& getRecorder(sf::Vector2u size) {
+        auto& recorder = recorders[{size.x, size.y}];
+        if (!recorder) {
+            recorder = std::make_unique<GIFRecorder>(size.x, size.y, 300, 30.0f);
+            recorder->setImageFormat(options.imageFormat);
+        }
+        return *recorder;
+    }
+
+    // --seed for headless renders, so they are reproducible; random otherwise
+    unsigned int nextSeed() {
+        return options.enabled ? options.seed : randomDevice();
+    }
+};
+
+using SketchFactory = std::function<std::unique_ptr<Sketch>(SketchResources&)>;
+
+struct SketchEntry {
+    std::string name;
+    std::string description;
+    SketchFactory create;
+};
+
+// The sketches a program can show, in menu order. A factory may return
+// nullptr if the sketch cannot start (e.g. a missing font).
+class SketchRegistry {
+private:
+    std::vector<SketchEntry> entries;
+
+public:
+    void add(const std::string& name, const std::string& description, SketchFactory factory) {
+        entries.push_back({name, description, std::move(factory)});
+    }
+
+    // For sketch classes with NAME and DESCRIPTION and a constructor
+    // taking SketchResources&. Sketches that can fail to start register a
+    // factory of their own instead.
+    template <typename T>
+    void add() {
+        add(T::NAME, T::DESCRIPTION, [](SketchResources& resources) -> std::unique_ptr<Sketch> {
+            return std::make_unique<T>(resources);
+        });
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    const SketchEntry& at(size_t index) const {
+        return entries[index];
+    }
+
+    // Index of the named sketch, or -1
+    int find(const std::string& name) const {
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].name == name) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+};
+
+#endif // SKETCH_HPP
@@ -0,0 +1,286 @@
+#ifndef SKETCH_HOST_HPP
+#define SKETCH_HOST_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include "Sketch.hpp"
+
+// Runs the sketches of a registry in one window, or one of them headless.
+// Sketches are created the first time they are shown and kept, so
+// switching back and forth (Tab, or the number keys) reuses the window,
+// its GL context, the fonts and the recorders.
+//
+// Keys: R reset, S save image, G record, F recording format, Q quit.
+class SketchHost {
+private:
+    const SketchRegistry& registry;
+    SketchResources& resources;
+    std::vector<std::unique_ptr<Sketch>> sketches;
+    std::vector<bool> failed;
+    int current;
+
+    sf::RenderWindow window;
+    bool saveRequested;
+
+    // Creates the sketch on first use; nullptr if it cannot start
+    Sketch* getSketch(int index) {
+        if (!sketches[index] && !failed[index]) {
+            auto start = std::chrono::steady_clock::now();
+            sketches[index] = registry.at(index).create(resources);
+            failed[index] = !sketches[index];
+            if (sketches[index] && window.isOpen()) {
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                std::cout << "Started " << registry.at(index).name << " in " << ms << " ms." << std::endl;
+            }
+        }
+        return sketches[index].get();
+    }
+
+    std::string windowTitle() const {
+        return registry.at(current).name + " - " + registry.at(current).description;
+    }
+
+    // Fits the window to the sketch at 'index'; false if it cannot start
+    bool switchTo(int index) {
+        if (index == current || index < 0 || index >= static_cast<int>(registry.size())) {
+            return false;
+        }
+        Sketch* sketch = getSketch(index);
+        if (!sketch) {
+            std::cerr << "Could not start " << registry.at(index).name << "." << std::endl;
+            return false;
+        }
+
+        // A recording belongs to one sketch
+        GIFRecorder& recorder = resources.getRecorder(getSketch(current)->getSize());
+        if (recorder.isRecordingNow()) {
+            recorder.stopRecording();
+        }
+
+        current = index;
+        sf::Vector2u size = sketch->getSize();
+        if (window.getSize() != size) {
+            window.setSize(size);
+        }
+        window.setView(sf::View(sf::FloatRect(0.0f, 0.0f, static_cast<float>(size.x), static_cast<float>(size.y))));
+        window.setTitle(windowTitle());
+        window.setFramerateLimit(sketch->getFrameRateLimit());
+        return true;
+    }
+
+    void toggleRecording(Sketch& sketch) {
+        GIFRecorder& recorder = resources.getRecorder(sketch.getSize());
+        if (recorder.isRecordingNow()) {
+            recorder.stopRecording();
+            return;
+        }
+
+        // Sketches with a fixed set of colors skip per-frame quantization;
+        // the overlay text is white
+        std::vector<sf::Color> colors = sketch.getRecordingColors();
+        if (colors.empty()) {
+            recorder.clearPalette();
+        } else {
+            colors.push_back(sf::Color::White);
+            recorder.setPalette(colors, sf::Color::Black);
+        }
+        recorder.setFPS(sketch.getRecordingFPS());
+        recorder.startRecording();
+    }
+
+    void saveImage() {
+        sf::Texture texture;
+        texture.create(window.getSize().x, window.getSize().y);
+        texture.update(window);
+
+        std::time_t now = std::time(nullptr);
+        std::tm* localTime = std::localtime(&now);
+        char timestamp[32];
+        std::strftime(timestamp, sizeof(timestamp), "_%Y%m%d_%H%M%S", localTime);
+        const ImageWriter& writer = resources.getImageWriter();
+        std::string path = registry.at(current).name + timestamp + writer.extension();
+        if (writer.write(path, texture.copyToImage())) {
+            std::cout << "Saved image to " << path << std::endl;
+        } else {
+            std::cerr << "Failed to save image." << std::endl;
+        }
+    }
+
+    void handleKey(const sf::Event::KeyEvent& event) {
+        sf::Keyboard::Key key = event.code;
+        Sketch& sketch = *getSketch(current);
+        GIFRecorder& recorder = resources.getRecorder(sketch.getSize());
+        if (key == sf::Keyboard::Q) {
+            window.close();
+        } else if (key == sf::Keyboard::R) {
+            sketch.reset();
+        } else if (key == sf::Keyboard::S) {
+            saveRequested = true;
+        } else if (key == sf::Keyboard::G) {
+            toggleRecording(sketch);
+        } else if (key == sf::Keyboard::F && !recorder.isRecordingNow()) {
+            // Cycle GIF -> image sequence -> raw spool -> Y4M video
+            int next = (static_cast<int>(recorder.getFormat()) + 1) % 4;
+            recorder.setFormat(static_cast<RecordingFormat>(next));
+            std::cout << "Recording format: " << GIFRecorder::formatName(recorder.getFormat()) << std::endl;
+        } else if (key == sf::Keyboard::Tab && registry.size() > 1) {
+            // Shift+Tab goes back
+            int count = static_cast<int>(registry.size());
+            for (int step = 1; step < count; ++step) {
+                int index = (current + (event.shift ? count - step : step)) % count;
+                if (switchTo(index)) {
+                    break;
+                }
+            }
+        } else if (key >= sf::Keyboard::Num1 && key <= sf::Keyboard::Num9 && registry.size() > 1) {
+            switchTo(key - sf::Keyboard::Num1);
+        }
+    }
+
+    void drawOverlay(Sketch& sketch, float fps) {
+        const sf::Font* font = resources.getFont("montana-light.ttf");
+        if (!font) {
+            return;
+        }
+        const GIFRecorder& recorder = resources.getRecorder(sketch.getSize());
+
+        std::string keys = "R: Reset | S: Save Image | G: Record | F: Format (" +
+                           std::string(GIFRecorder::formatName(recorder.getFormat())) + ") | Q: Quit";
+        if (registry.size() > 1) {
+            keys += " | Tab: Next sketch";
+        }
+        std::vector<std::string> lines = {keys};
+        if (!sketch.getHelp().empty()) {
+            lines.push_back(sketch.getHelp());
+        }
+        std::string status = "FPS: " + std::to_string(static_cast<int>(fps));
+        if (!sketch.getStatus().empty()) {
+            status += " | " + sketch.getStatus();
+        }
+        lines.push_back(status);
+        if (recorder.isRecordingNow()) {
+            lines.push_back("Recording: " + std::to_string(recorder.getRecordedFrames()) + "/" +
+                            std::to_string(recorder.getMaxFrames()) + " | Dropped: " +
+                            std::to_string(recorder.getDroppedFrames()) + " | Queue: " +
+                            std::to_string(recorder.getQueueDepth()));
+        }
+
+        sf::Text text;
+        text.setFont(*font);
+        text.setCharacterSize(16);
+        text.setFillColor(sf::Color::White);
+        sf::Vector2f position = sketch.getOverlayPosition();
+        for (const std::string& line : lines) {
+            text.setString(line);
+            text.setPosition(position);
+            window.draw(text);
+            position.y += 20.0f;
+        }
+    }
+
+public:
+    SketchHost(const SketchRegistry& sketchRegistry, SketchResources& sketchResources)
+        : registry(sketchRegistry), resources(sketchResources), sketches(sketchRegistry.size()),
+          failed(sketchRegistry.size(), false), current(-1), saveRequested(false) {}
+
+    // Renders the sketch offscreen for --headless. Returns the exit code.
+    int renderHeadless(int index) {
+        Sketch* sketch = getSketch(index);
+        if (!sketch) {
+            return 1;
+        }
+        sf::Vector2u size = sketch->getSize();
+        HeadlessRenderer renderer(size.x, size.y, resources.getOptions());
+        std::vector<sf::Color> colors = sketch->getRecordingColors();
+        if (!colors.empty()) {
+            renderer.getRecorder().setPalette(colors, sf::Color::Black);
+        }
+        const SketchInput input;
+        renderer.run([&](float deltaTime) { sketch->update(deltaTime, input); },
+                     [&](sf::RenderTarget& target) { sketch->draw(target); });
+        return 0;
+    }
+
+    // Opens the window on the sketch at 'index' and runs until it is
+    // closed. Returns the exit code.
+    int run(int index) {
+        if (resources.isHeadless()) {
+            return renderHeadless(index);
+        }
+
+        // The first sketch asks for what it needs before the window opens
+        Sketch* sketch = getSketch(index);
+        if (!sketch) {
+            return 1;
+        }
+        resources.setPromptsAllowed(false);
+
+        current = index;
+        sf::Vector2u size = sketch->getSize();
+        window.create(sf::VideoMode(size.x, size.y), windowTitle(), sf::Style::Close);
+        window.setFramerateLimit(sketch->getFrameRateLimit());
+
+        sf::Clock clock;
+        sf::Clock fpsClock;
+        int frameCount = 0;
+        float fps = 0.0f;
+
+        while (window.isOpen()) {
+            int shown = current;
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                if (event.type == sf::Event::Closed) {
+                    window.close();
+                } else if (!getSketch(current)->handleEvent(event) && event.type == sf::Event::KeyPressed) {
+                    handleKey(event.key);
+                }
+            }
+            if (!window.isOpen()) {
+                break;
+            }
+
+            // Creating a sketch can take a while; it should not see that as time passing
+            float deltaTime = clock.restart().asSeconds();
+            if (current != shown) {
+                deltaTime = 0.0f;
+                frameCount = 0;
+                fpsClock.restart();
+            }
+
+            sketch = getSketch(current);
+            SketchInput input;
+            input.mouse = static_cast<sf::Vector2f>(sf::Mouse::getPosition(window));
+            input.hasMouse = true;
+            input.mousePressed = sf::Mouse::isButtonPressed(sf::Mouse::Left);
+            sketch->update(deltaTime, input);
+
+            frameCount++;
+            if (fpsClock.getElapsedTime().asSeconds() >= 1.0f) {
+                fps = frameCount / fpsClock.restart().asSeconds();
+                frameCount = 0;
+            }
+
+            sketch->draw(window);
+            drawOverlay(*sketch, fps);
+            if (saveRequested) {
+                saveImage();
+                saveRequested = false;
+            }
+            window.display();
+            resources.getRecorder(sketch->getSize()).update(deltaTime, window);
+        }
+
+        GIFRecorder& recorder = resources.getRecorder(getSketch(current)->getSize());
+        if (recorder.isRecordingNow()) {
+            recorder.stopRecording();
+        }
+        return 0;
+    }
+};
+
+#endif // SKETCH_HOST_HPP
@@ -0,0 +1,58 @@
+#ifndef SPSC_QUEUE_HPP
+#define SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+// Bounded queue from one producer thread to one consumer thread. Neither
+// side locks or waits: push() fails when the queue is full and pop() when
+// it is empty. Head and tail sit on their own cache lines, so the two
+// threads do not invalidate each other's on every call.
+template <typename T>
+class SpscQueue {
+private:
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head; // next to pop; written by the consumer
+    alignas(64) std::atomic<size_t> tail; // next to push; written by the producer
+
+public:
+    // Holds capacity items, rounded up to a power of two
+    explicit SpscQueue(size_t capacity = 64) : head(0), tail(0) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    bool push(const T& item) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        if (position - head.load(std::memory_order_acquire) == slots.size()) {
+            return false;
+        }
+        slots[position & mask] = item;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        size_t position = head.load(std::memory_order_relaxed);
+        if (position == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = slots[position & mask];
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Drops everything; only while neither thread is using the queue
+    void clear() {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+    }
+};
+
+#endif // SPSC_QUEUE_HPP
@@ -0,0 +1,150 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+// Reusable barrier for a fixed number of threads. Waiters spin briefly and
+// then yield, which suits phases of tens of microseconds that a condition
+// variable would double in length.
+class SpinBarrier {
+private:
+    const int count;
+    std::atomic<int> arrived;
+    std::atomic<uint32_t> phase;
+
+public:
+    explicit SpinBarrier(int count) : count(count), arrived(0), phase(0) {}
+
+    void wait() {
+        uint32_t current = phase.load(std::memory_order_acquire);
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+            arrived.store(0, std::memory_order_relaxed);
+            phase.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        int spins = 0;
+        while (phase.load(std::memory_order_acquire) == current) {
+            if (++spins > 64) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+// Fixed set of threads that all run the same job, for data-parallel loops
+// that need to synchronize between phases. The calling thread takes part
+// as worker 0, so a pool of one runs jobs inline.
+//
+//   pool.run([&](int worker, int workers) {
+//       auto range = ThreadPool::split(items, worker, workers);
+//       ...first phase over range...
+//       pool.sync();
+//       ...second phase...
+//   });
+class ThreadPool {
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const std::function<void(int, int)>* job;
+    uint64_t generation;
+    int running;
+    bool stopping;
+    SpinBarrier barrier;
+
+    void workerLoop(int worker) {
+        uint64_t seen = 0;
+        for (;;) {
+            const std::function<void(int, int)>* current;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+                current = job;
+            }
+            (*current)(worker, size());
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --running;
+            }
+            finished.notify_one();
+        }
+    }
+
+    static int threadCount(unsigned int requested) {
+        return static_cast<int>(requested ? requested : std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+public:
+    // threads = 0 uses every hardware thread
+    explicit ThreadPool(unsigned int threads = 0)
+        : job(nullptr), generation(0), running(0), stopping(false), barrier(threadCount(threads)) {
+        for (int i = 1; i < threadCount(threads); ++i) {
+            this->threads.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const {
+        return static_cast<int>(threads.size()) + 1;
+    }
+
+    // Runs job(worker, size()) on every worker; returns when all are done
+    void run(const std::function<void(int, int)>& task) {
+        if (threads.empty()) {
+            task(0, 1);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            running = static_cast<int>(threads.size());
+            ++generation;
+        }
+        wake.notify_all();
+        task(0, size());
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this] { return running == 0; });
+    }
+
+    // Waits for every worker to reach this point; only valid inside run()
+    void sync() {
+        if (!threads.empty()) {
+            barrier.wait();
+        }
+    }
+
+    // The worker's share of [0, count), in contiguous blocks
+    static std::pair<size_t, size_t> split(size_t count, int worker, int workers) {
+        size_t begin = count * worker / workers;
+        size_t end = count * (worker + 1) / workers;
+        return {begin, end};
+    }
+};
+
+#endif // THREAD_POOL_HPP
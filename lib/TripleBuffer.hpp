@@ -0,0 +1,65 @@
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <atomic>
+
+// Hands the latest of a stream of values from one writer thread to one
+// reader thread without either waiting. The writer fills its own slot and
+// swaps it into the middle; the reader swaps the middle into its own slot
+// when it holds something new. Values the reader is too slow to see are
+// overwritten, and slots are reused, so a value's buffers are only
+// allocated once.
+//
+//   Writer:                      Reader:
+//   fill(buffer.write());        buffer.update();
+//   buffer.publish();            draw(buffer.read());
+template <typename T>
+class TripleBuffer {
+private:
+    // Set in middle while it holds a value the reader has not taken
+    static constexpr int FRESH = 4;
+    static constexpr int SLOT = 3;
+
+    T slots[3];
+    std::atomic<int> middle;
+    int back;
+    int front;
+
+public:
+    TripleBuffer() : middle(1), back(0), front(2) {}
+
+    // The writer's slot; holds whatever was published two values ago
+    T& write() {
+        return slots[back];
+    }
+
+    void publish() {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & SLOT;
+    }
+
+    // Takes the latest published value, if there is a new one
+    bool update() {
+        if (!(middle.load(std::memory_order_acquire) & FRESH)) {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & SLOT;
+        return true;
+    }
+
+    // The reader's slot: the value taken by the last update()
+    const T& read() const {
+        return slots[front];
+    }
+
+    // Empties every slot; only while neither thread is using the buffer
+    void reset() {
+        for (T& slot : slots) {
+            slot = T();
+        }
+        middle.store(1, std::memory_order_release);
+        back = 0;
+        front = 2;
+    }
+};
+
+#endif // TRIPLE_BUFFER_HPP
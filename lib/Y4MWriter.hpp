@@ -0,0 +1,214 @@
+#ifndef Y4M_WRITER_HPP
+#define Y4M_WRITER_HPP
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// RGBA -> I420 (planar 4:2:0, BT.601 limited range) conversion. Chroma is
+// the average of each 2x2 block. The SSE2 path uses the same integer math
+// as the scalar reference, so both produce identical output.
+namespace yuv {
+
+    inline uint8_t lumaOf(const uint8_t* p) {
+        return static_cast<uint8_t>(((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16);
+    }
+
+    // r, g, b are sums over up to four pixels, scaled to four samples
+    inline uint8_t chromaU(int r, int g, int b) {
+        return static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 512) >> 10) + 128);
+    }
+
+    inline uint8_t chromaV(int r, int g, int b) {
+        return static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 512) >> 10) + 128);
+    }
+
+    inline void convertLumaRow(const uint8_t* rgba, uint8_t* y, int width) {
+        int x = 0;
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i coef = _mm_set_epi16(0, 25, 129, 66, 0, 25, 129, 66);
+        const __m128i bias = _mm_set1_epi32(128);
+        const __m128i offset = _mm_set1_epi16(16);
+
+        // Weighted R*cR + G*cG and B*cB for 4 pixels, summed per pixel
+        auto luma4 = [&](__m128i px) {
+            __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(px, zero), coef);
+            __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(px, zero), coef);
+            __m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+            __m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1)));
+            return _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(even, odd), bias), 8);
+        };
+
+        for (; x + 16 <= width; x += 16) {
+            const __m128i* src = reinterpret_cast<const __m128i*>(rgba + x * 4);
+            __m128i a = luma4(_mm_loadu_si128(src));
+            __m128i b = luma4(_mm_loadu_si128(src + 1));
+            __m128i c = luma4(_mm_loadu_si128(src + 2));
+            __m128i d = luma4(_mm_loadu_si128(src + 3));
+            __m128i ab = _mm_add_epi16(_mm_packs_epi32(a, b), offset);
+            __m128i cd = _mm_add_epi16(_mm_packs_epi32(c, d), offset);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(y + x), _mm_packus_epi16(ab, cd));
+        }
+#endif
+        for (; x < width; ++x) {
+            y[x] = lumaOf(rgba + x * 4);
+        }
+    }
+
+    // One chroma row from two RGBA rows (row1 may equal row0 on odd heights)
+    inline void convertChromaRow(const uint8_t* row0, const uint8_t* row1, uint8_t* u, uint8_t* v, int width) {
+        int cx = 0;
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i coefU = _mm_set_epi16(0, 112, -74, -38, 0, 112, -74, -38);
+        const __m128i coefV = _mm_set_epi16(0, -18, -94, 112, 0, -18, -94, 112);
+        const __m128i bias = _mm_set1_epi32(512);
+        const __m128i offset = _mm_set1_epi16(128);
+
+        // 2x2 sums for the two blocks covered by 4 pixels of each row
+        auto blocks2 = [&](__m128i top, __m128i bottom) {
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+            lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+            return _mm_unpacklo_epi64(lo, hi);
+        };
+        auto weigh = [&](__m128i first, __m128i second, __m128i coef) {
+            __m128i a = _mm_madd_epi16(first, coef);
+            __m128i b = _mm_madd_epi16(second, coef);
+            __m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0)));
+            __m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(3, 1, 3, 1)));
+            return _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(even, odd), bias), 10);
+        };
+
+        for (; cx * 2 + 16 <= width; cx += 8) {
+            const __m128i* top = reinterpret_cast<const __m128i*>(row0 + cx * 8);
+            const __m128i* bottom = reinterpret_cast<const __m128i*>(row1 + cx * 8);
+            __m128i b0 = blocks2(_mm_loadu_si128(top), _mm_loadu_si128(bottom));
+            __m128i b1 = blocks2(_mm_loadu_si128(top + 1), _mm_loadu_si128(bottom + 1));
+            __m128i b2 = blocks2(_mm_loadu_si128(top + 2), _mm_loadu_si128(bottom + 2));
+            __m128i b3 = blocks2(_mm_loadu_si128(top + 3), _mm_loadu_si128(bottom + 3));
+
+            __m128i uVals = _mm_add_epi16(_mm_packs_epi32(weigh(b0, b1, coefU), weigh(b2, b3, coefU)), offset);
+            __m128i vVals = _mm_add_epi16(_mm_packs_epi32(weigh(b0, b1, coefV), weigh(b2, b3, coefV)), offset);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(u + cx), _mm_packus_epi16(uVals, uVals));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(v + cx), _mm_packus_epi16(vVals, vVals));
+        }
+#endif
+        int chromaWidth = (width + 1) / 2;
+        for (; cx < chromaWidth; ++cx) {
+            // On odd widths the last block repeats its single column
+            int x0 = cx * 2;
+            int x1 = std::min(x0 + 1, width - 1);
+            int r = row0[x0 * 4] + row0[x1 * 4] + row1[x0 * 4] + row1[x1 * 4];
+            int g = row0[x0 * 4 + 1] + row0[x1 * 4 + 1] + row1[x0 * 4 + 1] + row1[x1 * 4 + 1];
+            int b = row0[x0 * 4 + 2] + row0[x1 * 4 + 2] + row1[x0 * 4 + 2] + row1[x1 * 4 + 2];
+            u[cx] = chromaU(r, g, b);
+            v[cx] = chromaV(r, g, b);
+        }
+    }
+
+    // Converts a width x height RGBA image into the three I420 planes
+    inline void rgbaToI420(const uint8_t* rgba, int width, int height, uint8_t* y, uint8_t* u, uint8_t* v) {
+        const size_t rowBytes = static_cast<size_t>(width) * 4;
+        const int chromaWidth = (width + 1) / 2;
+
+        for (int row = 0; row < height; ++row) {
+            convertLumaRow(rgba + row * rowBytes, y + static_cast<size_t>(row) * width, width);
+        }
+        for (int row = 0; row < height; row += 2) {
+            const uint8_t* row0 = rgba + row * rowBytes;
+            const uint8_t* row1 = row + 1 < height ? row0 + rowBytes : row0;
+            size_t offset = static_cast<size_t>(row / 2) * chromaWidth;
+            convertChromaRow(row0, row1, u + offset, v + offset, width);
+        }
+    }
+}
+
+// Streaming YUV4MPEG2 writer. Any encoder that reads y4m (ffmpeg, x264,
+// aomenc...) can consume the output directly through a pipe when the path
+// is "-" (stdout).
+class Y4MWriter {
+private:
+    FILE* file;
+    bool ownsFile;
+    int width;
+    int height;
+    std::vector<uint8_t> planes;
+
+public:
+    Y4MWriter() : file(nullptr), ownsFile(false), width(0), height(0) {}
+
+    ~Y4MWriter() {
+        close();
+    }
+
+    bool open(const std::string& path, int w, int h, float fps) {
+        close();
+        if (path == "-") {
+            file = stdout;
+            ownsFile = false;
+        } else {
+            file = std::fopen(path.c_str(), "wb");
+            ownsFile = true;
+        }
+        if (!file) {
+            std::cerr << "Failed to open " << path << " for writing." << std::endl;
+            return false;
+        }
+
+        width = w;
+        height = h;
+        size_t lumaSize = static_cast<size_t>(w) * h;
+        size_t chromaSize = static_cast<size_t>((w + 1) / 2) * ((h + 1) / 2);
+        planes.resize(lumaSize + 2 * chromaSize);
+
+        // Frame rate as a fraction, e.g. 30000:1000 or 29970:1000
+        long rate = std::lround(fps * 1000.0f);
+        std::fprintf(file, "YUV4MPEG2 W%d H%d F%ld:1000 Ip A1:1 C420jpeg\n", w, h, rate);
+        return true;
+    }
+
+    // Writes one RGBA frame 'repeat' times (the conversion is done once)
+    bool writeFrame(const uint8_t* rgba, int repeat = 1) {
+        if (!file) {
+            return false;
+        }
+
+        size_t lumaSize = static_cast<size_t>(width) * height;
+        size_t chromaSize = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+        uint8_t* y = planes.data();
+        uint8_t* u = y + lumaSize;
+        uint8_t* v = u + chromaSize;
+        yuv::rgbaToI420(rgba, width, height, y, u, v);
+
+        for (int i = 0; i < repeat; ++i) {
+            std::fputs("FRAME\n", file);
+            if (std::fwrite(planes.data(), 1, planes.size(), file) != planes.size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void close() {
+        if (file) {
+            std::fflush(file);
+            if (ownsFile) {
+                std::fclose(file);
+            }
+            file = nullptr;
+        }
+    }
+};
+
+#endif // Y4M_WRITER_HPP
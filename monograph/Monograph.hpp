@@ -19,9 +19,8 @@ public:
         map.resize(w, std::vector<double>(h, 0.0));
     }
 
-    void generateRandom() {
-        std::random_device rd;
-        std::mt19937 gen(rd());
+    void generateRandom(unsigned int seed) {
+        std::mt19937 gen(seed);
         std::uniform_real_distribution<> dis(0.0, 1.0);
         for (int i = 0; i < width; ++i) {
             for (int j = 0; j < height; ++j) {
@@ -72,10 +71,10 @@ struct Shape {
 class Monograph {
 private:
     std::vector<Shape> shapes;
-    sf::RenderWindow& window;
+    int width;
+    int height;
     Lightmap detailMap;
     std::vector<sf::Color> palette;
-    std::random_device rd;
     std::mt19937 gen;
 
     void subdivide(sf::FloatRect bounds, int depth) {
@@ -140,22 +139,23 @@ private:
     }
 
 public:
-    Monograph(sf::RenderWindow& win, int width, int height, const std::string& paletteName)
-        : window(win), detailMap(width, height), gen(rd()) {
+    // The same seed always produces the same sequence of compositions
+    Monograph(int w, int h, const std::string& paletteName, unsigned int seed = std::random_device{}())
+        : width(w), height(h), detailMap(w, h), gen(seed) {
         palette = getPalette(paletteName);
-        detailMap.generateRandom();
+        detailMap.generateRandom(gen());
         generate();
     }
 
     void generate() {
         shapes.clear();
-        sf::FloatRect initialBounds(0, 0, window.getSize().x, window.getSize().y);
+        sf::FloatRect initialBounds(0, 0, width, height);
         subdivide(initialBounds, 6);
     }
 
-    void draw() {
+    void draw(sf::RenderTarget& target) {
         // background color
-        window.clear(sf::Color::Black);
+        target.clear(sf::Color::Black);
         for (const auto& shape : shapes) {
             sf::Color cornerColor = sf::Color::Black;
 
@@ -177,9 +177,9 @@ public:
                 cutoutRect.setPosition(shape.rect.getPosition().x + shape.rect.getSize().x - radius, shape.rect.getPosition().y + shape.rect.getSize().y - radius);
             }
 
-            window.draw(shape.rect);
-            window.draw(cutoutRect);
-            window.draw(shape.cornerCircle);
+            target.draw(shape.rect);
+            target.draw(cutoutRect);
+            target.draw(shape.cornerCircle);
         }
     }
 
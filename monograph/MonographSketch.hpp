@@ -0,0 +1,65 @@
+#ifndef MONOGRAPH_SKETCH_HPP
+#define MONOGRAPH_SKETCH_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include "Monograph.hpp"
+#include "../lib/Sketch.hpp"
+
+// A still piece, regenerated with R. Headless renders show a new
+// composition every simulated second.
+class MonographSketch : public Sketch {
+private:
+    static constexpr int WIDTH = 800;
+    static constexpr int HEIGHT = 800;
+
+    std::string paletteName;
+    Monograph monograph;
+    int frame;
+
+public:
+    static constexpr const char* NAME = "monograph";
+    static constexpr const char* DESCRIPTION = "Subdivided rectangles with rounded corners";
+
+    explicit MonographSketch(SketchResources& resources)
+        : paletteName(resources.getPaletteName()), monograph(WIDTH, HEIGHT, paletteName, resources.nextSeed()),
+          frame(0) {}
+
+    sf::Vector2u getSize() const override {
+        return sf::Vector2u(WIDTH, HEIGHT);
+    }
+
+    void reset() override {
+        monograph.generate();
+        std::cout << "Regenerated artwork." << std::endl;
+    }
+
+    void update(float deltaTime, const SketchInput& input) override {
+        if (input.hasMouse || deltaTime <= 0.0f) {
+            return;
+        }
+        const int framesPerComposition = std::max(1, static_cast<int>(std::lround(1.0f / deltaTime)));
+        if (frame > 0 && frame % framesPerComposition == 0) {
+            monograph.generate();
+        }
+        frame++;
+    }
+
+    void draw(sf::RenderTarget& target) override {
+        monograph.draw(target);
+    }
+
+    std::string getStatus() const override {
+        return "Palette: " + paletteName;
+    }
+
+    std::vector<sf::Color> getRecordingColors() const override {
+        return getPalette(paletteName);
+    }
+};
+
+#endif // MONOGRAPH_SKETCH_HPP
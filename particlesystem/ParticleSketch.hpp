@@ -0,0 +1,101 @@
+#ifndef PARTICLE_SKETCH_HPP
+#define PARTICLE_SKETCH_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <memory>
+#include <random>
+#include <iostream>
+#include "text_particle_system.hpp"
+#include "../lib/Sketch.hpp"
+
+// Text made of particles that blows off with Space. Headless renders show
+// the text for HEADLESS_BLOW_OFF_TIME, then blow it off in a direction
+// chosen by the seed.
+class ParticleSketch : public Sketch {
+private:
+    static constexpr int WIDTH = 1000;
+    static constexpr int HEIGHT = 800;
+    static constexpr float HEADLESS_BLOW_OFF_TIME = 1.0f;
+
+    TextParticleSystem textParticles;
+    std::mt19937 gen;
+    bool blowOffTriggered;
+    float time;
+
+    void blowOff() {
+        std::uniform_real_distribution<float> dirDist(-1.0f, 1.0f);
+        sf::Vector2f direction(dirDist(gen), dirDist(gen));
+        textParticles.triggerBlowOff(direction, 200.0f, gen());
+        blowOffTriggered = true;
+    }
+
+public:
+    static constexpr const char* NAME = "particlesystem";
+    static constexpr const char* DESCRIPTION = "Text that blows off as particles";
+
+    ParticleSketch(SketchResources& resources, const sf::Font& font)
+        : gen(resources.nextSeed()), blowOffTriggered(false), time(0.0f) {
+        // --text replaces the prompt, e.g. for headless renders
+        std::string userText = resources.argument("--text");
+        if (userText.empty() && !resources.isHeadless() && resources.canPrompt()) {
+            std::cout << "Enter text for the particle effect: ";
+            std::getline(std::cin, userText);
+        }
+
+        if (userText.empty()) {
+            userText = "HELLO"; // Default text
+        }
+        textParticles.setText(userText, font, 72);
+        textParticles.reset();
+    }
+
+    // The text needs its font; nullptr without it
+    static std::unique_ptr<Sketch> create(SketchResources& resources) {
+        const sf::Font* font = resources.getFont("montana-bold.ttf");
+        if (!font) {
+            std::cerr << "Failed to load font!" << std::endl;
+            return nullptr;
+        }
+        return std::make_unique<ParticleSketch>(resources, *font);
+    }
+
+    sf::Vector2u getSize() const override {
+        return sf::Vector2u(WIDTH, HEIGHT);
+    }
+
+    void reset() override {
+        textParticles.reset();
+        blowOffTriggered = false;
+        time = 0.0f;
+    }
+
+    bool handleEvent(const sf::Event& event) override {
+        if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Space) {
+            if (!blowOffTriggered) {
+                blowOff();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void update(float deltaTime, const SketchInput& input) override {
+        time += deltaTime;
+        if (!input.hasMouse && !blowOffTriggered && time >= HEADLESS_BLOW_OFF_TIME) {
+            blowOff();
+        }
+        textParticles.update(sf::seconds(deltaTime));
+    }
+
+    void draw(sf::RenderTarget& target) override {
+        target.clear(sf::Color::Black);
+        target.draw(textParticles);
+    }
+
+    std::string getHelp() const override {
+        return "Space: Blow off text";
+    }
+};
+
+#endif // PARTICLE_SKETCH_HPP
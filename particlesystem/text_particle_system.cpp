@@ -48,12 +48,16 @@ void TextParticleSystem::setText(const std::string& text, const sf::Font& font,
 }
 
 void TextParticleSystem::triggerBlowOff(const sf::Vector2f& forceDirection, float forceStrength) {
+    std::random_device rd;
+    triggerBlowOff(forceDirection, forceStrength, rd());
+}
+
+void TextParticleSystem::triggerBlowOff(const sf::Vector2f& forceDirection, float forceStrength, unsigned int seed) {
     m_blowOffTriggered = true;
     m_forceDirection = forceDirection;
     m_forceStrength = forceStrength;
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    std::mt19937 gen(seed);
     std::uniform_real_distribution<float> velDist(-2.0f, 2.0f);
 
     for (size_t i = 0; i < m_particles.size(); ++i) {
@@ -26,6 +26,9 @@ public:
     // Applies a force to all particles to make them "blow off"
     void triggerBlowOff(const sf::Vector2f& forceDirection, float forceStrength);
 
+    // Same, with particle velocities drawn from a fixed seed
+    void triggerBlowOff(const sf::Vector2f& forceDirection, float forceStrength, unsigned int seed);
+
     // Updates the position, velocity, and lifetime of each particle
     void update(sf::Time elapsed);
 
@@ -0,0 +1,88 @@
+#ifndef SMITH_TILES_SKETCH_HPP
+#define SMITH_TILES_SKETCH_HPP
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+#include "SmithTile.hpp"
+#include "../lib/Sketch.hpp"
+
+// A random tiling, regenerated with R. Headless renders show a new tiling
+// every simulated second.
+class SmithTilesSketch : public Sketch {
+private:
+    static constexpr int WIDTH = 800;
+    static constexpr int HEIGHT = 800;
+    static constexpr int TILE_SIZE = 100;
+
+    std::string paletteName;
+    std::vector<sf::Color> palette;
+    std::mt19937 gen;
+    std::uniform_int_distribution<> dis;
+    std::vector<SmithTile> tiles;
+    int frame;
+
+    void generateTiles() {
+        const int gridsize = WIDTH / TILE_SIZE;
+        tiles.clear();
+        for (int y = 0; y < gridsize; ++y) {
+            for (int x = 0; x < gridsize; ++x) {
+                sf::Vector2f position(x * TILE_SIZE, y * TILE_SIZE);
+                int variant = dis(gen);
+                sf::Color color = palette[(y * gridsize + x) % palette.size()];
+                tiles.emplace_back(position, TILE_SIZE, color, variant);
+            }
+        }
+    }
+
+public:
+    static constexpr const char* NAME = "smithtiles";
+    static constexpr const char* DESCRIPTION = "Smith tiles in two random orientations";
+
+    explicit SmithTilesSketch(SketchResources& resources)
+        : paletteName(resources.getPaletteName()), palette(getPalette(paletteName)), gen(resources.nextSeed()),
+          dis(0, 1), frame(0) {
+        generateTiles();
+    }
+
+    sf::Vector2u getSize() const override {
+        return sf::Vector2u(WIDTH, HEIGHT);
+    }
+
+    void reset() override {
+        generateTiles();
+        std::cout << "Regenerated artwork." << std::endl;
+    }
+
+    void update(float deltaTime, const SketchInput& input) override {
+        if (input.hasMouse || deltaTime <= 0.0f) {
+            return;
+        }
+        const int framesPerTiling = std::max(1, static_cast<int>(std::lround(1.0f / deltaTime)));
+        if (frame > 0 && frame % framesPerTiling == 0) {
+            generateTiles();
+        }
+        frame++;
+    }
+
+    void draw(sf::RenderTarget& target) override {
+        target.clear(sf::Color::Black);
+        for (auto& tile : tiles) {
+            tile.draw(target);
+        }
+    }
+
+    std::string getStatus() const override {
+        return "Palette: " + paletteName;
+    }
+
+    std::vector<sf::Color> getRecordingColors() const override {
+        return palette;
+    }
+};
+
+#endif // SMITH_TILES_SKETCH_HPP